@@ -1,6 +1,7 @@
 #include "Game.h"
 
 #include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <thread>
 
@@ -37,22 +38,23 @@ const SpriteRepository::Sprite& Truck::get_sprite() {
     return SpriteRepository::get_truck();
 }
 
-Road::Road()
+Road::Road(ConsoleEngine& engine)
     : player(2 * SpriteRepository::width, height - SpriteRepository::height),
-      engine(),
+      engine(engine),
       objects(),
+      road(width, height),
       dist(0) {
     clear();
     engine.clear();
+    engine.resize_buffer(screen_width, screen_height);
+    engine.start_render_thread();
 }
 std::vector<int> Road::free_pos() {
     std::vector<int> pos;
-    std::string& first_row = road[0];
-    for (int i = 0; i < first_row.size(); ++i) {
+    for (int i = 0; i < width; ++i) {
         bool free = true;
-        for (int j = i; j < i + SpriteRepository::width && j < first_row.size();
-             ++j) {
-            if (first_row[j] != '.') {
+        for (int j = i; j < i + SpriteRepository::width && j < width; ++j) {
+            if (road.at(j, 0).glyph != '.') {
                 free = false;
                 break;
             }
@@ -87,70 +89,54 @@ bool Road::update() {
             ++it;
         }
     }
+    // Дорога уезжает вниз на строку за шаг, вместе с машинами скорости 1.
+    // Если машин таких много, терминал прокрутит ее сам
+    engine.scroll_region(2, screen_height, -1);
+    bool is_colision = compose();
+    if (!is_colision) ++dist;
+    return is_colision;
+}
+bool Road::compose() {
     clear();
     render_objs();
     bool is_colision = render_player();
     if (is_colision) {
         render_broken_player();
     }
-    if (!is_colision) ++dist;
     return is_colision;
 }
-void Road::clear() {
-    std::string empty_line(width, '.');  // строка из `width` точек
-    for (auto& line : road) {
-        line = empty_line;
-    }
-}
+void Road::clear() { road.fill('.'); }
 void Road::draw() {
-    engine.set_cursor_to_zero();
-
-    engine.print("Best score: ", max_dist, "\n");
-    engine.print("Score: ", dist, "\n");
-    for (auto& row : road) {
-        engine.print(row, "\n");
-    }
+    engine.draw_text(0, 0, "Best score: " + std::to_string(max_dist));
+    engine.draw_text(0, 1, "Score: " + std::to_string(dist));
+    engine.blit(0, 2, road);
+    engine.present();
 }
 void Road::render_objs() {
     for (auto& obj : objects) {
-        const SpriteRepository::Sprite& sprite = obj->get_sprite();
-        for (int y = std::max(obj->get_pos_y(), 0);
-             y < std::min(height, obj->get_pos_y() + obj->height); ++y) {
-            for (int x = obj->get_pos_x();
-                 x < std::min(width, obj->get_pos_x() + obj->width); ++x) {
-                road[y][x] = sprite[y - obj->get_pos_y()][x - obj->get_pos_x()];
-            }
-        }
+        road.blit(obj->get_pos_x(), obj->get_pos_y(), obj->get_sprite());
     }
 }
 
 bool Road::render_player() {
-    bool is_colision = false;
     const SpriteRepository::Sprite& sprite = player.get_sprite();
     for (int y = player.get_pos_y();
          y < std::min(height, player.get_pos_y() + player.height); ++y) {
         for (int x = player.get_pos_x();
              x < std::min(width, player.get_pos_x() + player.width); ++x) {
-            if (road[y][x] != '.' &&
+            if (road.at(x, y).glyph != '.' &&
                 sprite[y - player.get_pos_y()][x - player.get_pos_x()] != '.') {
                 return true;
             }
-            road[y][x] = sprite[y - player.get_pos_y()][x - player.get_pos_x()];
         }
     }
-    return is_colision;
+    road.blit(player.get_pos_x(), player.get_pos_y(), sprite);
+    return false;
 }
 
 void Road::render_broken_player() {
-    const SpriteRepository::Sprite& sprite =
-        SpriteRepository::get_broken_player();
-    for (int y = player.get_pos_y();
-         y < std::min(height, player.get_pos_y() + player.height); ++y) {
-        for (int x = player.get_pos_x();
-             x < std::min(width, player.get_pos_x() + player.width); ++x) {
-            road[y][x] = sprite[y - player.get_pos_y()][x - player.get_pos_x()];
-        }
-    }
+    road.blit(player.get_pos_x(), player.get_pos_y(),
+              SpriteRepository::get_broken_player());
 }
 
 int Road::get_score() { return dist; }
@@ -175,35 +161,54 @@ void CarGenerator::generate(Road& road) {
     }
 }
 
-void CarRacing::get_player_commands() {
-    if (engine.key_pressed('A')) {
-        road.player.set_pos_x(std::max(0, road.player.get_pos_x() - 1));
-    } else if (engine.key_pressed('D')) {
-        road.player.set_pos_x(std::min(road.width - road.player.width,
-                                       road.player.get_pos_x() + 1));
+bool CarRacing::get_player_commands() {
+    int old_pos = road.player.get_pos_x();
+    KeyEvent event;
+    while (engine.poll_event(event)) {
+        // Одно нажатие - один шаг. Автоповтор зажатой клавиши двигает
+        // машину не чаще раза в STEER_INTERVAL
+        if (event.time - last_steer < STEER_INTERVAL) continue;
+        char c = event.key == Key::Char ? char(std::toupper(event.ch)) : '\0';
+        if (event.key == Key::Left || c == 'A') {
+            road.player.set_pos_x(std::max(0, road.player.get_pos_x() - 1));
+        } else if (event.key == Key::Right || c == 'D') {
+            road.player.set_pos_x(std::min(road.width - road.player.width,
+                                           road.player.get_pos_x() + 1));
+        } else {
+            continue;
+        }
+        last_steer = event.time;
     }
+    return road.player.get_pos_x() != old_pos;
 }
 
-CarRacing::CarRacing() : road(), engine() {}
+CarRacing::CarRacing() : engine(), road(engine) {}
 CarRacing::~CarRacing() {}
 void CarRacing::play() {
     road.set_max_dist(load_high_score());
-    is_running = true;
-    auto last_frame = std::chrono::steady_clock::now();
-    while (is_running) {
-        get_player_commands();
-
-        auto now = std::chrono::steady_clock::now();
-        if (now - last_frame >= FRAME_DURATION) {
-            bool is_colision = road.update();
-            road.draw();
-            is_running = !is_colision;
-            last_frame = now;
-        }
-
-        // Маленькая пауза, чтобы не грузить CPU
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+    GameLoop loop(FRAME_DURATION, std::chrono::milliseconds(16));
+    auto input = [&] {
+        bool has_commands = get_player_commands();
+        // Без ввода (stdin закрыт) рулить некому
+        if (engine.input_closed()) loop.stop();
+        if (!has_commands) return false;
+        // Поворот виден сразу, не дожидаясь шага дороги
+        if (road.compose()) loop.stop();
+        return true;
+    };
+    auto update = [&] {
+        if (road.update()) loop.stop();
+    };
+    auto render = [&] {
+        engine.stats().add_update_time(loop.update_time());
+        road.draw();
+    };
+    loop.set_wait([this](GameLoop::Clock::time_point deadline) {
+        engine.wait_input(deadline);
+    });
+    loop.run(input, update, render);
+    // Кадр со столкновением
+    road.draw();
     save_high_score();
 }
 
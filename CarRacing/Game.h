@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <concepts>
@@ -7,6 +8,7 @@
 #include <vector>
 
 #include "ConsoleEngine.h"
+#include "GameLoop.h"
 
 class SpriteRepository {
   public:
@@ -111,7 +113,10 @@ class Road {
   public:
     static constexpr int width = 5 * SpriteRepository::width;
     static constexpr int height = 5 * SpriteRepository::height;
-    Road();
+    // Две строки сверху занимает счет
+    static constexpr int screen_width = std::max(width, 24);
+    static constexpr int screen_height = height + 2;
+    explicit Road(ConsoleEngine& engine);
     template <typename T>
         requires std::derived_from<T, Object>
     void add_object(int pos_x, int pos_y) {
@@ -119,6 +124,8 @@ class Road {
     }
     bool update();
     void clear();
+    // Собирает дорогу из машин и игрока; true при столкновении
+    bool compose();
     void draw();
     void render_objs();
     bool render_player();
@@ -130,9 +137,10 @@ class Road {
     Player player;
 
   private:
-    ConsoleEngine engine;
+    ConsoleEngine& engine;
     std::list<std::unique_ptr<Object>> objects;
-    std::array<std::string, height> road;
+    // Собранная сцена: по ней же проверяются столкновения
+    FrameBuffer road;
     int dist;
     int max_dist;
 };
@@ -157,13 +165,18 @@ class CarRacing {
 
   private:
     static constexpr int max_x_move = 3;
+    // Один движок на игру: дорога рисует через него, игра читает ввод.
+    // Объявлен раньше road и поэтому переживает ее
+    ConsoleEngine engine;
     Road road;
-    bool is_running;
 
-    ConsoleEngine engine;
     const std::chrono::milliseconds FRAME_DURATION =
         std::chrono::milliseconds(250);
+    const std::chrono::milliseconds STEER_INTERVAL =
+        std::chrono::milliseconds(100);
+    std::chrono::steady_clock::time_point last_steer;
     const std::string highscore_filename = "highscore.txt";
 
-    void get_player_commands();
+    // true, если машина сдвинулась
+    bool get_player_commands();
 };
\ No newline at end of file
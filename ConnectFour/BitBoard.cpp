@@ -0,0 +1,71 @@
+#include "BitBoard.h"
+
+#include <array>
+
+namespace {
+// Случайный ключ на каждую клетку для каждого игрока. Генерируются при
+// компиляции (splitmix64), чтобы ключи не зависели от запуска
+constexpr std::array<std::array<uint64_t, 64>, 2> make_zobrist_keys() {
+    std::array<std::array<uint64_t, 64>, 2> keys{};
+    uint64_t state = 0;
+    for (auto& player_keys : keys) {
+        for (auto& key : player_keys) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+            key = z ^ (z >> 31);
+        }
+    }
+    return keys;
+}
+constexpr auto zobrist_keys = make_zobrist_keys();
+}  // namespace
+
+bool BitBoard::fits(int width, int height) {
+    return width > 0 && height > 0 && width * (height + 1) <= 64;
+}
+
+BitBoard::BitBoard(int width, int height) : width_(width), height_(height) {
+    for (int col = 0; col < width; ++col) full_ |= column(col);
+}
+
+void BitBoard::play(int col, Participant p) {
+    uint64_t cell = (mask_ + bottom_cell(col)) & column(col);
+    int player = p == Participant::player1 ? 0 : 1;
+    pieces_[player] |= cell;
+    mask_ |= cell;
+    hash_ ^= zobrist_keys[player][std::countr_zero(cell)];
+}
+
+void BitBoard::undo(int col) {
+    // Сумма дает клетку над верхней фишкой, сдвиг - саму фишку
+    uint64_t cell = ((mask_ & column(col)) + bottom_cell(col)) >> 1;
+    int player = (pieces_[0] & cell) ? 0 : 1;
+    hash_ ^= zobrist_keys[player][std::countr_zero(cell)];
+    pieces_[0] &= ~cell;
+    pieces_[1] &= ~cell;
+    mask_ &= ~cell;
+}
+
+Participant BitBoard::at(int col, int row) const {
+    uint64_t cell = bottom_cell(col) << row;
+    if (pieces_[0] & cell) return Participant::player1;
+    if (pieces_[1] & cell) return Participant::player2;
+    return Participant::none;
+}
+
+Participant BitBoard::winner() const {
+    if (has_four(pieces_[0])) return Participant::player1;
+    if (has_four(pieces_[1])) return Participant::player2;
+    return Participant::none;
+}
+
+bool BitBoard::has_four(uint64_t pieces) const {
+    // Вертикаль, горизонталь и две диагонали: сдвиг на соседнюю клетку
+    const int shifts[] = {1, height_ + 1, height_, height_ + 2};
+    for (int shift : shifts) {
+        uint64_t pairs = pieces & (pieces >> shift);
+        if (pairs & (pairs >> 2 * shift)) return true;
+    }
+    return false;
+}
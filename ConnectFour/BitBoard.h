@@ -0,0 +1,63 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+enum class Participant { player1, player2, none };
+
+// Позиция в виде битовых масок. Столбец занимает height + 1 бит снизу
+// вверх, верхний бит всегда пустой - он не дает четверкам переходить
+// через край. Поэтому width * (height + 1) должно быть не больше 64
+// (7x7, 8x6 и т.п.)
+class BitBoard {
+  public:
+    // Столбец занимает хотя бы два бита
+    static constexpr int max_width = 32;
+
+    static bool fits(int width, int height);
+
+    BitBoard(int width, int height);
+
+    bool can_play(int col) const { return (mask_ & top_cell(col)) == 0; }
+    bool is_full() const { return mask_ == full_; }
+    // Ставит фишку p в столбец col, который не заполнен
+    void play(int col, Participant p);
+    // Снимает верхнюю фишку столбца col
+    void undo(int col);
+    // Чья фишка в столбце col на строке row (0 - нижняя строка)
+    Participant at(int col, int row) const;
+    Participant winner() const;
+    // Номер бита, в который упадет фишка в столбце col
+    int next_cell(int col) const {
+        return std::countr_zero((mask_ + bottom_cell(col)) & column(col));
+    }
+    int empty_cells() const { return std::popcount(full_ & ~mask_); }
+    // Ключ Зобриста: меняется на каждом ходе и отмене, одинаковые позиции
+    // при любом порядке ходов получают один ключ
+    uint64_t hash() const { return hash_; }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+  private:
+    int width_;
+    int height_;
+    // Фишки каждого игрока
+    uint64_t pieces_[2] = {0, 0};
+    // Все занятые клетки. В каждом столбце они идут подряд от нижней,
+    // так что следующая свободная клетка - mask_ + bottom_cell(col)
+    uint64_t mask_ = 0;
+    // Все клетки доски без служебной верхней строки
+    uint64_t full_ = 0;
+    uint64_t hash_ = 0;
+
+    uint64_t bottom_cell(int col) const {
+        return uint64_t(1) << (col * (height_ + 1));
+    }
+    uint64_t top_cell(int col) const {
+        return uint64_t(1) << (col * (height_ + 1) + height_ - 1);
+    }
+    uint64_t column(int col) const {
+        return ((uint64_t(1) << height_) - 1) << (col * (height_ + 1));
+    }
+    bool has_four(uint64_t pieces) const;
+};
@@ -1,6 +1,7 @@
 #include "Game.h"
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 char to_char(Participant p) {
@@ -19,71 +20,66 @@ Board::Board(int width, int height)
     : width(width),
       height(height),
       engine(),
-      board(height, std::vector<Participant>(width, Participant::none)) {}
+      position(width, height) {
+    if (!BitBoard::fits(width, height))
+        throw std::invalid_argument("Board does not fit in 64 bits");
+    engine.clear();
+    engine.resize_buffer(width * 2 + 1, height + 1);
+}
 
 int Board::get_new_cursor_pos(int cursor) {
     draw(cursor);
-    std::string input = engine.get();
-    while (!input.empty()) {
-        for (const auto& c : input) {
-            if (c == 'a') {
-                cursor = std::max(cursor - 1, 0);
-            } else if (c == 'd') {
-                cursor = std::min(cursor + 1, width - 1);
-            }
+    KeyEvent event;
+    // Курсор двигается сразу по нажатию, без Enter после каждой строки.
+    // Между нажатиями поток спит
+    while (engine.wait_event(event)) {
+        char c = event.key == Key::Char ? event.ch : '\0';
+        if (event.key == Key::Left || c == 'a') {
+            cursor = std::max(cursor - 1, 0);
+        } else if (event.key == Key::Right || c == 'd') {
+            cursor = std::min(cursor + 1, width - 1);
+        } else if (event.key == Key::Enter || c == ' ') {
+            break;
         }
         draw(cursor);
-        input = engine.get();
     }
-    return cursor;
+    return engine.input_closed() ? -1 : cursor;
 }
 
 void Board::draw(int cursor) {
-    engine.clear();
+    ConsoleFrame frame(engine);
     draw_cursor(cursor);
     draw_board();
+    engine.present();
+    // Итог партии печатается под доской
+    engine.set_cursor_to_pos(0, height + 1);
 }
 
 void Board::draw_cursor(int cursor) {
-    for (int i = 0; i <= cursor * 2; ++i) {
-        engine.print(' ');
-    }
-    engine.print('v');  // TODO: рассмотреть возможность смены цвета или самого
-                        // курсора для разных игроков
-    for (int i = cursor * 2; i <= (width + 1) * 2; ++i) {
-        engine.print(' ');
-    }
-    engine.print('\n');
+    engine.draw_text(0, 0, std::string(width * 2 + 1, ' '));
+    // TODO: рассмотреть возможность смены цвета или самого курсора для
+    // разных игроков
+    engine.set_cell(cursor * 2 + 1, 0, 'v');
 }
 
 void Board::draw_board() {
-    for (const auto& row : board) {
-        for (const auto& p : row) {
-            engine.print('|', to_char(p));
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            engine.set_cell(col * 2, row + 1, '|');
+            Participant p = position.at(col, height - 1 - row);
+            engine.set_cell(col * 2 + 1, row + 1, to_char(p));
         }
-        engine.print('|', '\n');
+        engine.set_cell(width * 2, row + 1, '|');
     }
 }
 
 bool Board::try_add_piece(int cursor, Participant p) {
     if (is_col_fill(cursor)) return false;
-    int row = 0;
-    while (row < height && board[row][cursor] == Participant::none) ++row;
-    board[row - 1][cursor] = p;
+    position.play(cursor, p);
     draw(cursor);
     return true;
 }
 
-Board Board::add_piece_to_new(int cursor, Participant p) {
-    if (is_col_fill(cursor)) return *this;
-    Board new_board = *this;
-    int row = 0;
-    while (row < height && new_board.board[row][cursor] == Participant::none)
-        ++row;
-    new_board.board[row - 1][cursor] = p;
-    return new_board;
-}
-
 void Board::set_winner(Participant p) {
     // engine.clear();
     if (p == Participant::player1)
@@ -94,124 +90,10 @@ void Board::set_winner(Participant p) {
         engine.print("Draw");
 }
 
-bool Board::is_col_fill(int col) { return board[0][col] != Participant::none; }
-bool Board::is_fill() {
-    for (int i = 0; i < width; ++i) {
-        if (!is_col_fill(i)) return false;
-    }
-    return true;
-}
+bool Board::is_col_fill(int col) { return !position.can_play(col); }
+bool Board::is_fill() { return position.is_full(); }
 
-Participant Board::check_win() {
-    if (auto result = check_row_win(); result != Participant::none)
-        return result;
-    if (auto result = check_col_win(); result != Participant::none)
-        return result;
-    if (auto result = check_diag1_win(); result != Participant::none)
-        return result;
-    if (auto result = check_diag2_win(); result != Participant::none)
-        return result;
-    return Participant::none;
-}
-Participant Board::check_win_for_current_pos(Participant& prev,
-                                             Participant& curr,
-                                             int& player1_count,
-                                             int& player2_count) {
-    if (curr != prev) {
-        switch (curr) {
-            case Participant::player1:
-                player1_count = 1;
-                player2_count = 0;
-                break;
-            case Participant::player2:
-                player2_count = 1;
-                player1_count = 0;
-                break;
-            default:
-                player1_count = 0;
-                player2_count = 0;
-                break;
-        }
-    } else {
-        switch (curr) {
-            case Participant::player1:
-                ++player1_count;
-                break;
-            case Participant::player2:
-                ++player2_count;
-                break;
-            default:
-                break;
-        }
-    }
-    if (player1_count >= 4) return Participant::player1;
-    if (player2_count >= 4) return Participant::player2;
-    return Participant::none;
-}
-Participant Board::check_row_win() {
-    for (int row = 0; row < height; ++row) {
-        int player1_count = 0;
-        int player2_count = 0;
-        Participant prev = Participant::none;
-        for (int col = 0; col < width; ++col) {
-            Participant& curr = board[row][col];
-            Participant winner = check_win_for_current_pos(
-                prev, curr, player1_count, player2_count);
-            if (winner != Participant::none) return winner;
-            prev = curr;
-        }
-    }
-    return Participant::none;
-}
-Participant Board::check_col_win() {
-    for (int col = 0; col < width; ++col) {
-        int player1_count = 0;
-        int player2_count = 0;
-        Participant prev = Participant::none;
-        for (int row = 0; row < height; ++row) {
-            Participant& curr = board[row][col];
-            Participant winner = check_win_for_current_pos(
-                prev, curr, player1_count, player2_count);
-            if (winner != Participant::none) return winner;
-            prev = curr;
-        }
-    }
-    return Participant::none;
-}
-Participant Board::check_diag1_win() {
-    for (int d = 3; d < width + height - 1 - 3; ++d) {
-        int row = std::max(0, height - d - 1);
-        int col = std::max(0, d - height + 1);
-        int player1_count = 0;
-        int player2_count = 0;
-        Participant prev = Participant::none;
-        for (int i = 0; i < std::min(height - row, width - col); ++i) {
-            Participant& curr = board[row + i][col + i];
-            Participant winner = check_win_for_current_pos(
-                prev, curr, player1_count, player2_count);
-            if (winner != Participant::none) return winner;
-            prev = curr;
-        }
-    }
-    return Participant::none;
-}
-Participant Board::check_diag2_win() {
-    for (int d = 3; d < width + height - 1 - 3; ++d) {
-        int row = std::min(height - 1, d);
-        int col = std::max(0, d - height + 1);
-        int player1_count = 0;
-        int player2_count = 0;
-        Participant prev = Participant::none;
-        for (int i = 0; i < std::min(row + 1, width - col); ++i) {
-            Participant& curr = board[row - i][col + i];
-            Participant winner = check_win_for_current_pos(
-                prev, curr, player1_count, player2_count);
-            if (winner != Participant::none) return winner;
-            prev = curr;
-        }
-    }
-    return Participant::none;
-}
+Participant Board::check_win() { return position.winner(); }
 
 ConnectFour::ConnectFour(int width, int height, std::unique_ptr<Player> player1,
                          std::unique_ptr<Player> player2)
@@ -251,7 +133,7 @@ ConnectFour ConnectFour::HumanVsHuman(int width, int height) {
 void ConnectFour::play() {
     Participant winner;
     while (true) {
-        player1->move(board);
+        if (!player1->move(board)) return;
         winner = board.check_win();
         if (winner != Participant::none) {
             board.set_winner(winner);
@@ -262,7 +144,7 @@ void ConnectFour::play() {
             return;
         }
 
-        player2->move(board);
+        if (!player2->move(board)) return;
         winner = board.check_win();
         if (winner != Participant::none) {
             board.set_winner(winner);
@@ -280,24 +162,27 @@ Player::Player(Participant participant) : participant(participant) {}
 HumanPlayer::HumanPlayer(Participant p) : Player(p) {}
 
 ComputerPlayer::ComputerPlayer(Participant p, ComputeParams params)
-    : Player(p), compute_params(params) {}
+    : Player(p), compute_params(params), table(params.table_size) {}
 
-void HumanPlayer::move(Board& board) {
+bool HumanPlayer::move(Board& board) {
     bool valid_move = false;
     while (!valid_move) {
-        cursor = board.get_new_cursor_pos(cursor);
+        int choice = board.get_new_cursor_pos(cursor);
+        if (choice < 0) return false;
+        cursor = choice;
         valid_move = board.try_add_piece(cursor, participant);
     }
+    return true;
 }
 
-void ComputerPlayer::move(Board& board) {
+bool ComputerPlayer::move(Board& board) {
     switch (compute_params.move_type) {
         case MoveTypes::random:
             random_move(board);
-            break;
+            return true;
         case MoveTypes::minimax:
             minimax_move(board);
-            break;
+            return true;
         default:
             std::cerr << "Undefined type of computer";
             throw std::runtime_error("Undefined type of computer");
@@ -313,9 +198,24 @@ void ComputerPlayer::random_move(Board& board) {
     }
 }
 
+// Оценка победы зависит от глубины, на которой она найдена, считая от
+// корня. В таблице она хранится от самой позиции, иначе после следующего
+// хода (корень сдвинулся) оценки из таблицы станут неверными
+int ComputerPlayer::score_to_table(int score, int depth) {
+    if (score > 0) return score + depth;
+    if (score < 0) return score - depth;
+    return score;
+}
+int ComputerPlayer::score_from_table(int score, int depth) {
+    if (score > 0) return score - depth;
+    if (score < 0) return score + depth;
+    return score;
+}
+
 ComputerPlayer::MoveResult ComputerPlayer::calculate_next_move(
-    Board board, Participant p, int depth, int alpha, int beta) {
-    Participant winner = board.check_win();
+    BitBoard& position, Participant p, int depth, int alpha, int beta) {
+    ++nodes;
+    Participant winner = position.winner();
     if (winner != Participant::none) {
         int base_score = (winner == participant) ? 1 : -1;
         int scaled_score = base_score * (1000 - depth + 1);
@@ -324,20 +224,56 @@ ComputerPlayer::MoveResult ComputerPlayer::calculate_next_move(
 
     if (compute_params.max_depth != -1 and depth > compute_params.max_depth)
         return {0, -1};
-    if (board.is_fill()) return {0, -1};
+    if (position.is_full()) return {0, -1};
+
+    // Сколько полуходов осталось просчитать из этой позиции. Полный
+    // просчет до конца партии подходит для любой глубины
+    int remaining = position.empty_cells();
+    if (compute_params.max_depth != -1)
+        remaining = std::min(remaining, compute_params.max_depth + 1 - depth);
+
+    // Та же позиция могла получиться другим порядком ходов
+    // Даже неглубокая запись подсказывает, какой ход проверить первым
+    uint64_t key = position.hash();
+    int table_move = -1;
+    if (auto entry = table.find(key)) {
+        table_move = entry->move;
+        if (entry->depth >= remaining) {
+            int score = score_from_table(entry->score, depth);
+            if (entry->bound == Bound::exact) return {score, entry->move};
+            if (entry->bound == Bound::lower)
+                alpha = std::max(alpha, score);
+            else
+                beta = std::min(beta, score);
+            if (beta <= alpha) return {score, entry->move};
+        }
+    }
+    int window_alpha = alpha;
+    int window_beta = beta;
 
     bool is_maximizing = (p == participant);
     int best_score = is_maximizing ? -1000 : +1000;
     int best_move = -1;
 
-    for (int i = 0; i < board.width; ++i) {
-        if (board.is_col_fill(i)) continue;
+    MoveOrdering::Moves moves;
+    int count = 0;
+    if (compute_params.move_ordering) {
+        count = ordering.order(position, p, depth, table_move, moves);
+    } else {
+        for (int i = 0; i < position.width(); ++i)
+            if (position.can_play(i)) moves[count++] = i;
+    }
 
-        auto next_check = calculate_next_move(board.add_piece_to_new(i, p),
+    for (int k = 0; k < count; ++k) {
+        int i = moves[k];
+        // Ход делается и отменяется на месте, позиция не копируется
+        position.play(i, p);
+        auto next_check = calculate_next_move(position,
                                               p == Participant::player1
                                                   ? Participant::player2
                                                   : Participant::player1,
                                               depth + 1, alpha, beta);
+        position.undo(i);
         if (is_maximizing) {
             if (next_check.score > best_score) {
                 best_score = next_check.score;
@@ -353,13 +289,32 @@ ComputerPlayer::MoveResult ComputerPlayer::calculate_next_move(
             beta = std::min(beta, best_score);
         }
 
-        if (beta <= alpha) break;
+        if (beta <= alpha) {
+            if (compute_params.move_ordering)
+                ordering.cutoff(position, p, depth, i, remaining);
+            break;
+        }
     }
+
+    Bound bound = Bound::exact;
+    if (best_score <= window_alpha)
+        bound = Bound::upper;
+    else if (best_score >= window_beta)
+        bound = Bound::lower;
+    table.store(key, score_to_table(best_score, depth), remaining, best_move,
+                bound);
     return {best_score, best_move};
 }
 
+ComputerPlayer::MoveResult ComputerPlayer::analyze(const BitBoard& position) {
+    BitBoard copy = position;
+    table.new_search();
+    ordering.new_search();
+    return calculate_next_move(copy, participant, 0);
+}
+
 void ComputerPlayer::minimax_move(Board& board) {
-    auto next_check = calculate_next_move(board, participant, 0);
+    auto next_check = analyze(board.get_position());
     if (next_check.column != -1)
         board.try_add_piece(next_check.column, participant);
     else
@@ -371,9 +326,11 @@ std::unique_ptr<Player> player_from_string(std::string params, Participant p) {
         return std::make_unique<HumanPlayer>(p);
     }
     if (params.rfind("minimax:", 0) == 0) {
-        int depth = std::stoi(params.substr(8));
-        return std::make_unique<ComputerPlayer>(
-            p, ComputeParams{MoveTypes::minimax, depth});
+        // minimax:DEPTH или minimax:DEPTH:TABLE_SIZE
+        ComputeParams compute{MoveTypes::minimax, std::stoi(params.substr(8))};
+        if (auto pos = params.find(':', 8); pos != std::string::npos)
+            compute.table_size = std::stoul(params.substr(pos + 1));
+        return std::make_unique<ComputerPlayer>(p, compute);
     }
     if (params.rfind("random", 0) == 0) {
         return std::make_unique<ComputerPlayer>(
@@ -1,48 +1,51 @@
 #pragma once
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
-#include <vector>
 
+#include "BitBoard.h"
 #include "ConsoleEngine.h"
+#include "MoveOrdering.h"
+#include "TranspositionTable.h"
 
 enum class MoveTypes { random, minimax };
 
-enum class Participant { player1, player2, none };
-
 char to_char(Participant p);
 
 struct ComputeParams {
     MoveTypes move_type = MoveTypes::minimax;
     int max_depth = 6;
+    // Записей в таблице просчитанных позиций (16 байт каждая), 0 - без нее
+    std::size_t table_size = std::size_t(1) << 18;
+    // Сначала проверять сильные ходы; без этого - по порядку столбцов
+    bool move_ordering = true;
 };
 
+// Доска на экране. Для перебора ходов есть BitBoard без ввода-вывода,
+// копировать Board вместе с ConsoleEngine незачем
 class Board {
   public:
     const int width;
     const int height;
 
     Board(int width, int height);
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
     void draw(int cursor);
+    // -1, если ввод закончился и выбора уже не будет
     int get_new_cursor_pos(int cursor);
     bool try_add_piece(int cursor, Participant p);
-    Board add_piece_to_new(int cursor, Participant p);
     void set_winner(Participant p);
 
     Participant check_win();
     bool is_col_fill(int col);
     bool is_fill();
+    const BitBoard& get_position() const { return position; }
 
   private:
     ConsoleEngine engine;
-    std::vector<std::vector<Participant>> board;
-    Participant check_win_for_current_pos(Participant& prev, Participant& curr,
-                                          int& player1_count,
-                                          int& player2_count);
-    Participant check_row_win();
-    Participant check_col_win();
-    Participant check_diag1_win();
-    Participant check_diag2_win();
+    BitBoard position;
     void draw_cursor(int cursor);
     void draw_board();
 };
@@ -51,35 +54,48 @@ class Player {
   public:
     Player(Participant participant);
     virtual ~Player() = default;
-    virtual void move(Board& board) = 0;
+    // false, если игрок ушел: ввод закончился, ход не сделан
+    virtual bool move(Board& board) = 0;
 
   protected:
     Participant participant;
 };
 
 class ComputerPlayer : public Player {
+  public:
     struct MoveResult {
         int score;
         int column;
     };
 
-  public:
     ComputerPlayer(Participant participant,
                    ComputeParams params = ComputeParams{MoveTypes::minimax, 6});
-    void move(Board& board) override;
+    bool move(Board& board) override;
+    // Перебор из position, где ходит participant, без доски на экране.
+    // column == -1, если партия окончена или проигрывает любой ход
+    MoveResult analyze(const BitBoard& position);
+    // Сколько позиций просмотрено за партию
+    uint64_t searched_nodes() const { return nodes; }
 
   private:
     ComputeParams compute_params;
+    // Живет всю партию: позиции из прошлых ходов снова встречаются
+    TranspositionTable table;
+    MoveOrdering ordering;
+    uint64_t nodes = 0;
     void random_move(Board& board);
     void minimax_move(Board& board);
-    MoveResult calculate_next_move(Board board, Participant p, int depth,
-                                   int alpha = INT_MIN, int beta = INT_MAX);
+    static int score_to_table(int score, int depth);
+    static int score_from_table(int score, int depth);
+    MoveResult calculate_next_move(BitBoard& position, Participant p,
+                                   int depth, int alpha = INT_MIN,
+                                   int beta = INT_MAX);
 };
 
 class HumanPlayer : public Player {
   public:
     HumanPlayer(Participant participant);
-    void move(Board& board) override;
+    bool move(Board& board) override;
 
   private:
     int cursor = 0;
@@ -0,0 +1,47 @@
+#include "MoveOrdering.h"
+
+void MoveOrdering::new_search() {
+    for (auto& killers : killers_) killers = {-1, -1};
+    for (auto& side_history : history_)
+        for (int& value : side_history) value /= 2;
+}
+
+int MoveOrdering::order(const BitBoard& position, Participant p, int ply,
+                        int table_move, Moves& moves) const {
+    const int width = position.width();
+    std::array<int, BitBoard::max_width> scores;
+    int count = 0;
+    for (int k = 0; k < width; ++k) {
+        // От центра к краям: 3, 2, 4, 1, 5, 0, 6
+        int col = width / 2 + ((k & 1) ? -(k + 1) / 2 : k / 2);
+        if (!position.can_play(col)) continue;
+        int score = history_[side(p)][position.next_cell(col)];
+        if (col == killers_[ply][1]) score = max_history + 1;
+        if (col == killers_[ply][0]) score = max_history + 2;
+        if (col == table_move) score = max_history + 3;
+        // Вставка с сохранением порядка от центра при равных оценках
+        int i = count++;
+        for (; i > 0 && scores[i - 1] < score; --i) {
+            moves[i] = moves[i - 1];
+            scores[i] = scores[i - 1];
+        }
+        moves[i] = col;
+        scores[i] = score;
+    }
+    return count;
+}
+
+void MoveOrdering::cutoff(const BitBoard& position, Participant p, int ply,
+                          int col, int remaining) {
+    auto& killers = killers_[ply];
+    if (killers[0] != col) {
+        killers[1] = killers[0];
+        killers[0] = int8_t(col);
+    }
+    int& value = history_[side(p)][position.next_cell(col)];
+    value += remaining * remaining;
+    if (value > max_history) {
+        for (auto& side_history : history_)
+            for (int& v : side_history) v /= 2;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "BitBoard.h"
+
+// Порядок ходов для alpha-beta: чем раньше проверен сильный ход, тем
+// больше отсекается. Первым идет ход из таблицы позиций, затем
+// ходы-убийцы этого полухода, затем ходы с большей историей отсечений,
+// при равенстве - ближе к центру
+class MoveOrdering {
+  public:
+    using Moves = std::array<int, BitBoard::max_width>;
+
+    // Новый ход в партии: убийцы относятся к другим позициям, история
+    // остается, но теряет вес
+    void new_search();
+    // Записывает в moves доступные столбцы в порядке проверки и
+    // возвращает их число. table_move - ход из таблицы позиций или -1
+    int order(const BitBoard& position, Participant p, int ply, int table_move,
+              Moves& moves) const;
+    // Ход col в позиции position на полуходе ply дал отсечение
+    void cutoff(const BitBoard& position, Participant p, int ply, int col,
+                int remaining);
+
+  private:
+    static constexpr int max_ply = 65;
+    // Дальше история делится пополам, чтобы не переполниться
+    static constexpr int max_history = 1 << 28;
+
+    std::array<std::array<int8_t, 2>, max_ply> killers_{};
+    std::array<std::array<int, 64>, 2> history_{};
+
+    static int side(Participant p) {
+        return p == Participant::player1 ? 0 : 1;
+    }
+};
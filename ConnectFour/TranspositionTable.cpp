@@ -0,0 +1,29 @@
+#include "TranspositionTable.h"
+
+#include <bit>
+
+TranspositionTable::TranspositionTable(std::size_t size) {
+    if (size == 0) return;
+    entries_.resize(std::bit_floor(size));
+    mask_ = entries_.size() - 1;
+}
+
+const TranspositionTable::Entry* TranspositionTable::find(uint64_t key) const {
+    if (entries_.empty()) return nullptr;
+    const Entry& entry = entries_[key & mask_];
+    if (entry.depth == 0 || entry.key != key) return nullptr;
+    return &entry;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, int move,
+                               Bound bound) {
+    if (entries_.empty()) return;
+    Entry& entry = entries_[key & mask_];
+    if (entry.age == age_ && entry.depth > depth) return;
+    entry.key = key;
+    entry.score = int16_t(score);
+    entry.depth = uint8_t(depth);
+    entry.move = int8_t(move);
+    entry.bound = bound;
+    entry.age = age_;
+}
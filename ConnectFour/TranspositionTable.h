@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Какую оценку дал поиск в узле: точную или только границу, потому что
+// окно alpha-beta отсекло часть ходов
+enum class Bound : uint8_t { exact, lower, upper };
+
+// Таблица уже просчитанных позиций по ключу Зобриста. Размер - степень
+// двойки, индекс - младшие биты ключа. При коллизии остается запись с
+// большей глубиной просчета, но записи прошлых ходов вытесняются всегда
+class TranspositionTable {
+  public:
+    struct Entry {
+        uint64_t key = 0;
+        int16_t score = 0;
+        // Сколько полуходов просчитано от этой позиции; 0 - записи нет
+        uint8_t depth = 0;
+        int8_t move = -1;
+        Bound bound = Bound::exact;
+        uint8_t age = 0;
+    };
+
+    // size округляется вниз до степени двойки, 0 - таблица выключена
+    explicit TranspositionTable(std::size_t size);
+
+    const Entry* find(uint64_t key) const;
+    void store(uint64_t key, int score, int depth, int move, Bound bound);
+    // Начинается поиск нового хода: старые записи можно вытеснять
+    void new_search() { ++age_; }
+
+  private:
+    std::vector<Entry> entries_;
+    std::size_t mask_ = 0;
+    uint8_t age_ = 0;
+};
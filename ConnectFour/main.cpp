@@ -79,6 +79,14 @@ GameParams get_params_from_args(int argc, char* argv[]) {
             exit(0);
         }
     }
+    // Доска хранится в 64-битных масках: width * (height + 1) <= 64
+    if (!BitBoard::fits(params.width, params.height)) {
+        std::cerr << "Board " << params.width << "x" << params.height
+                  << " is too large, width * (height + 1) must be <= 64\n"
+                  << "Use default value: 7x6\n";
+        params.width = GameParams().width;
+        params.height = GameParams().height;
+    }
     return params;
 }
 
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "BitBoard.h"
+#include "Game.h"
+
+// Сколько позиций просматривает перебор с таблицей и порядком ходов и без
+// них. Запускать из Release-сборки: ConnectFourBench [MAX_DEPTH]
+// Глубина 12 без таблицы и порядка ходов считается несколько минут
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Одни и те же 50 позиций после 10 случайных ходов на доске 7x6
+std::vector<BitBoard> fixed_positions() {
+    std::mt19937 rng(2024);
+    std::vector<BitBoard> positions;
+    while (positions.size() < 50) {
+        BitBoard board(7, 6);
+        Participant p = Participant::player1;
+        for (int k = 0; k < 10 && board.winner() == Participant::none; ++k) {
+            int col = int(rng() % 7);
+            while (!board.can_play(col)) col = (col + 1) % 7;
+            board.play(col, p);
+            p = p == Participant::player1 ? Participant::player2
+                                          : Participant::player1;
+        }
+        if (board.winner() == Participant::none) positions.push_back(board);
+    }
+    return positions;
+}
+
+void run(const std::vector<BitBoard>& positions, int depth,
+         std::size_t table_size, bool move_ordering) {
+    ComputeParams params{MoveTypes::minimax, depth, table_size, move_ordering};
+    uint64_t nodes = 0;
+    long long score_sum = 0;
+    auto start = Clock::now();
+    for (const BitBoard& position : positions) {
+        // Своя таблица на каждую позицию, чтобы они не помогали друг другу
+        ComputerPlayer player(Participant::player1, params);
+        score_sum += player.analyze(position).score;
+        nodes += player.searched_nodes();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start);
+    std::printf("%5d %8zu %9s %15llu %9.2f s  scores %lld\n", depth,
+                table_size, move_ordering ? "on" : "off",
+                (unsigned long long)nodes, elapsed.count(), score_sum);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    int max_depth = argc > 1 ? std::atoi(argv[1]) : 12;
+    auto positions = fixed_positions();
+    std::printf("%5s %8s %9s %15s %11s\n", "depth", "table", "ordering",
+                "nodes", "time");
+    for (int depth = 8; depth <= max_depth; depth += 2)
+        for (std::size_t table_size : {std::size_t(0), std::size_t(1) << 18})
+            for (bool move_ordering : {false, true})
+                run(positions, depth, table_size, move_ordering);
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BitBoard.h"
+#include "Game.h"
+
+namespace {
+// Столбцы снизу вверх: 'x' - первый игрок, 'o' - второй
+BitBoard make_board(int width, int height,
+                    const std::vector<std::string>& columns) {
+    BitBoard board(width, height);
+    for (int col = 0; col < int(columns.size()); ++col)
+        for (char c : columns[col])
+            board.play(col, c == 'x' ? Participant::player1
+                                     : Participant::player2);
+    return board;
+}
+
+// Прямой перебор всех четверок по клеткам, без битовых сдвигов
+Participant naive_winner(const BitBoard& board) {
+    const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (int col = 0; col < board.width(); ++col) {
+        for (int row = 0; row < board.height(); ++row) {
+            Participant p = board.at(col, row);
+            if (p == Participant::none) continue;
+            for (auto [dc, dr] : directions) {
+                int k = 1;
+                for (; k < 4; ++k) {
+                    int c = col + dc * k, r = row + dr * k;
+                    if (c < 0 || c >= board.width() || r < 0 ||
+                        r >= board.height() || board.at(c, r) != p)
+                        break;
+                }
+                if (k == 4) return p;
+            }
+        }
+    }
+    return Participant::none;
+}
+}  // namespace
+
+TEST(BitBoardTest, FitsIn64Bits) {
+    EXPECT_TRUE(BitBoard::fits(7, 6));
+    EXPECT_TRUE(BitBoard::fits(7, 7));
+    EXPECT_TRUE(BitBoard::fits(8, 6));
+    EXPECT_TRUE(BitBoard::fits(8, 7));
+    EXPECT_TRUE(BitBoard::fits(9, 6));
+    EXPECT_TRUE(BitBoard::fits(32, 1));
+    EXPECT_FALSE(BitBoard::fits(8, 8));
+    EXPECT_FALSE(BitBoard::fits(9, 7));
+    EXPECT_FALSE(BitBoard::fits(10, 6));
+    EXPECT_FALSE(BitBoard::fits(33, 1));
+    EXPECT_FALSE(BitBoard::fits(0, 6));
+    EXPECT_FALSE(BitBoard::fits(7, 0));
+}
+
+TEST(BitBoardTest, VerticalWinAtTopOfLastColumn) {
+    // 8x7 занимает все 64 бита, служебный бит последнего столбца - старший
+    BitBoard board = make_board(8, 7, {"", "", "", "", "", "", "", "oooxxx"});
+    EXPECT_EQ(board.winner(), Participant::none);
+    board.play(7, Participant::player1);
+    EXPECT_EQ(board.winner(), Participant::player1);
+}
+
+TEST(BitBoardTest, VerticalDoesNotWrapIntoNextColumn) {
+    // Две фишки сверху столбца и две снизу следующего - не четверка
+    BitBoard board = make_board(7, 6, {"ooxoxx", "xx"});
+    EXPECT_EQ(board.winner(), Participant::none);
+}
+
+TEST(BitBoardTest, HorizontalWinAtRightEdge) {
+    BitBoard board = make_board(7, 6, {"", "", "", "x", "x", "x"});
+    EXPECT_EQ(board.winner(), Participant::none);
+    board.play(6, Participant::player1);
+    EXPECT_EQ(board.winner(), Participant::player1);
+}
+
+TEST(BitBoardTest, HorizontalWinOnTopRow) {
+    BitBoard board =
+        make_board(7, 6, {"xxxoxo", "xxoxoo", "oxxooo", "xoxox"});
+    EXPECT_EQ(board.winner(), Participant::none);
+    board.play(3, Participant::player2);
+    EXPECT_EQ(board.winner(), Participant::player2);
+}
+
+TEST(BitBoardTest, RisingDiagonalToTopRightCorner) {
+    BitBoard board =
+        make_board(7, 6, {"", "", "", "xox", "xxox", "xoxox", "oxoox"});
+    EXPECT_EQ(board.winner(), Participant::none);
+    board.play(6, Participant::player1);
+    EXPECT_EQ(board.winner(), Participant::player1);
+}
+
+TEST(BitBoardTest, FallingDiagonalFromTopLeftCorner) {
+    BitBoard board = make_board(7, 6, {"xooxx", "oxoxx", "xxox", "xox"});
+    EXPECT_EQ(board.winner(), Participant::none);
+    board.play(0, Participant::player1);
+    EXPECT_EQ(board.winner(), Participant::player1);
+}
+
+TEST(BitBoardTest, MatchesNaiveScanOnRandomGames) {
+    std::mt19937 rng(2024);
+    const int sizes[][2] = {{7, 6}, {4, 4}, {8, 7}, {9, 6}, {5, 10}, {16, 3}};
+    for (auto [width, height] : sizes) {
+        for (int game = 0; game < 200; ++game) {
+            BitBoard board(width, height);
+            Participant p = Participant::player1;
+            while (!board.is_full() && board.winner() == Participant::none) {
+                int col;
+                do {
+                    col = int(rng() % width);
+                } while (!board.can_play(col));
+                board.play(col, p);
+                ASSERT_EQ(board.winner(), naive_winner(board))
+                    << width << "x" << height << " game " << game;
+                p = p == Participant::player1 ? Participant::player2
+                                              : Participant::player1;
+            }
+        }
+    }
+}
+
+TEST(BitBoardTest, UndoRestoresPositionAndHash) {
+    std::mt19937 rng(7);
+    BitBoard board(7, 6);
+    std::vector<int> moves;
+    std::vector<uint64_t> hashes = {board.hash()};
+    Participant p = Participant::player1;
+    while (!board.is_full()) {
+        int col = int(rng() % 7);
+        if (!board.can_play(col)) continue;
+        board.play(col, p);
+        moves.push_back(col);
+        hashes.push_back(board.hash());
+        p = p == Participant::player1 ? Participant::player2
+                                      : Participant::player1;
+    }
+    BitBoard full = board;
+    EXPECT_EQ(board.empty_cells(), 0);
+
+    while (!moves.empty()) {
+        board.undo(moves.back());
+        moves.pop_back();
+        hashes.pop_back();
+        EXPECT_EQ(board.hash(), hashes.back());
+    }
+    EXPECT_EQ(board.hash(), 0u);
+    EXPECT_EQ(board.empty_cells(), 42);
+    for (int col = 0; col < 7; ++col)
+        for (int row = 0; row < 6; ++row)
+            EXPECT_EQ(board.at(col, row), Participant::none);
+
+    // Снятая и поставленная снова фишка дает тот же ключ, чужая - другой
+    uint64_t full_hash = full.hash();
+    Participant top = full.at(3, 5);
+    full.undo(3);
+    EXPECT_EQ(full.at(3, 5), Participant::none);
+    full.play(3, top);
+    EXPECT_EQ(full.hash(), full_hash);
+    full.undo(3);
+    full.play(3, top == Participant::player1 ? Participant::player2
+                                             : Participant::player1);
+    EXPECT_NE(full.hash(), full_hash);
+}
+
+TEST(BitBoardTest, HashDependsOnPositionNotMoveOrder) {
+    BitBoard a(7, 6), b(7, 6);
+    a.play(0, Participant::player1);
+    a.play(1, Participant::player2);
+    a.play(2, Participant::player1);
+    b.play(2, Participant::player1);
+    b.play(1, Participant::player2);
+    b.play(0, Participant::player1);
+    EXPECT_EQ(a.hash(), b.hash());
+
+    // Та же клетка у другого игрока - другой ключ
+    BitBoard c(7, 6);
+    c.play(0, Participant::player2);
+    c.play(1, Participant::player2);
+    c.play(2, Participant::player1);
+    EXPECT_NE(a.hash(), c.hash());
+}
+
+TEST(BitBoardTest, FullColumnCannotBePlayed) {
+    BitBoard board(7, 6);
+    for (int row = 0; row < 6; ++row) {
+        ASSERT_TRUE(board.can_play(3));
+        EXPECT_EQ(board.next_cell(3), 3 * 7 + row);
+        board.play(3, row % 2 ? Participant::player1 : Participant::player2);
+    }
+    EXPECT_FALSE(board.can_play(3));
+    // Заполненный столбец не переносится в соседний
+    EXPECT_TRUE(board.can_play(4));
+    EXPECT_EQ(board.next_cell(4), 4 * 7);
+    EXPECT_EQ(board.next_cell(2), 2 * 7);
+    EXPECT_FALSE(board.is_full());
+
+    board.undo(3);
+    EXPECT_TRUE(board.can_play(3));
+    EXPECT_EQ(board.next_cell(3), 3 * 7 + 5);
+}
+
+TEST(BitBoardTest, FullBoardOfAllBits) {
+    // 8x7: верхняя клетка последнего столбца рядом со старшим битом
+    BitBoard board(8, 7);
+    for (int col = 0; col < 8; ++col) {
+        for (int row = 0; row < 7; ++row) {
+            EXPECT_EQ(board.next_cell(col), col * 8 + row);
+            board.play(col, (row / 3 + col) % 2 ? Participant::player1
+                                                 : Participant::player2);
+        }
+        EXPECT_FALSE(board.can_play(col));
+    }
+    EXPECT_TRUE(board.is_full());
+    EXPECT_EQ(board.empty_cells(), 0);
+}
+
+namespace {
+// Позиция после plies случайных ходов, в которой еще никто не выиграл
+BitBoard random_position(std::mt19937& rng, int width, int height,
+                         int plies) {
+    while (true) {
+        BitBoard board(width, height);
+        Participant p = Participant::player1;
+        int k = 0;
+        for (; k < plies && board.winner() == Participant::none; ++k) {
+            int col = int(rng() % width);
+            if (!board.can_play(col)) break;
+            board.play(col, p);
+            p = p == Participant::player1 ? Participant::player2
+                                          : Participant::player1;
+        }
+        if (k == plies && board.winner() == Participant::none) return board;
+    }
+}
+}  // namespace
+
+// Таблица и порядок ходов только ускоряют перебор: оценка корня должна
+// совпасть с простым альфа-бета в порядке столбцов
+TEST(ComputerPlayerTest, TableAndOrderingKeepRootScore) {
+    std::mt19937 rng(42);
+    ComputeParams plain{MoveTypes::minimax, 7, 0, false};
+    ComputeParams table_only{MoveTypes::minimax, 7, std::size_t(1) << 12,
+                             false};
+    ComputeParams ordering_only{MoveTypes::minimax, 7, 0, true};
+    // Одна таблица на все позиции, как за партию
+    ComputerPlayer tuned(Participant::player1, {MoveTypes::minimax, 7});
+    for (int i = 0; i < 40; ++i) {
+        BitBoard position = random_position(rng, 7, 6, 10);
+        int expected =
+            ComputerPlayer(Participant::player1, plain).analyze(position).score;
+        EXPECT_EQ(ComputerPlayer(Participant::player1, table_only)
+                      .analyze(position)
+                      .score,
+                  expected)
+            << "position " << i;
+        EXPECT_EQ(ComputerPlayer(Participant::player1, ordering_only)
+                      .analyze(position)
+                      .score,
+                  expected)
+            << "position " << i;
+        EXPECT_EQ(tuned.analyze(position).score, expected) << "position " << i;
+    }
+}
+
+TEST(ComputerPlayerTest, FullSearchKeepsRootScore) {
+    // Перебор до конца партии: оценки побед из таблицы переносятся между
+    // разными глубинами
+    std::mt19937 rng(5);
+    ComputeParams plain{MoveTypes::minimax, -1, 0, false};
+    ComputeParams tuned{MoveTypes::minimax, -1};
+    for (int i = 0; i < 20; ++i) {
+        BitBoard position = random_position(rng, 5, 4, 8);
+        ComputerPlayer reference(Participant::player1, plain);
+        ComputerPlayer fast(Participant::player1, tuned);
+        EXPECT_EQ(fast.analyze(position).score,
+                  reference.analyze(position).score)
+            << "position " << i;
+        EXPECT_LT(fast.searched_nodes(), reference.searched_nodes());
+    }
+}
+
+TEST(ComputerPlayerTest, TakesImmediateWin) {
+    BitBoard position = make_board(7, 6, {"", "xxx", "ooo"});
+    ComputerPlayer player(Participant::player1, {MoveTypes::minimax, 4});
+    auto result = player.analyze(position);
+    EXPECT_EQ(result.column, 1);
+    EXPECT_GT(result.score, 0);
+    EXPECT_GT(player.searched_nodes(), 0u);
+}
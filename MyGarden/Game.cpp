@@ -10,20 +10,25 @@ Cell::Cell(int x, int y, std::unique_ptr<TerrainObject> terrain)
       is_on_path(false) {}
 
 void Cell::draw(ConsoleEngine& engine) {
-    engine.set_cursor_to_pos(pos_x, pos_y);
-    if (is_selected) engine.set_style(ConsoleStyle::Inverse);
-    if (is_on_path) engine.set_background_color(Colors256::Gray80);
+    ConsoleCell cell;
     if (entity)
-        engine.print_color(entity->get_color(), entity->get_sprite());
+        cell = ConsoleCell(entity->get_sprite(), entity->get_color());
     else
-        engine.print_color(terrain->get_color(), terrain->get_sprite());
-    engine.reset_styles();
+        cell = ConsoleCell(terrain->get_sprite(), terrain->get_color());
+    if (is_selected) cell.set_style(ConsoleStyle::Inverse);
+    if (is_on_path) cell.set_background_color(Colors256::Gray80);
+    engine.set_cell(pos_x, pos_y, cell);
 }
 
 Map::Map(int width, int height)
     : width(width), height(height), engine(), player(*this) {
-    engine.clear();
-    engine.hide_cursor();
+    {
+        ConsoleFrame frame(engine);
+        engine.clear();
+        engine.hide_cursor();
+    }
+    engine.resize_buffer(width, height);
+    engine.start_render_thread();
     map.resize(height);
     for (int y = 0; y < height; ++y) {
         map[y].reserve(width);
@@ -33,11 +38,20 @@ Map::Map(int width, int height)
     }
     map[player.cursor_pos.y][player.cursor_pos.x].is_selected = true;
     generate();
-    update();
+    render();
 }
 
 Cell& Map::get(int x, int y) { return map[y][x]; }
 
+int Map::visible_width() {
+    if (engine.terminal_width() <= 0) return width;
+    return std::min(width, engine.terminal_width());
+}
+int Map::visible_height() {
+    if (engine.terminal_height() <= 0) return height;
+    return std::min(height, engine.terminal_height());
+}
+
 void Map::generate() {
     generate_lakes();
     generate_rivers();
@@ -273,8 +287,8 @@ void Map::redraw_all() {
         }
     }
 }
+bool Map::handle_input() { return get_player_control(); }
 void Map::update() {
-    get_player_control();
     player_move();
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
@@ -284,6 +298,7 @@ void Map::update() {
         }
     }
 }
+void Map::render() { engine.present(); }
 
 void Map::clear_path() {
     if (!player.active_path.has_value()) return;
@@ -300,24 +315,30 @@ void Map::draw_path() {
     }
 }
 
-void Map::get_player_control() {
+bool Map::get_player_control() {
     auto old_cursor_pos = player.cursor_pos;
-    auto c = engine.get_no_wait();
-    while (c != '\0') {
-        if (c == 'a') {
+    // Меню читает ввод само, поэтому открываем его после разбора клавиш
+    bool open_action = false;
+    bool has_input = false;
+    KeyEvent event;
+    while (engine.poll_event(event)) {
+        has_input = true;
+        char c = event.key == Key::Char ? event.ch : '\0';
+        if (event.key == Key::Left || c == 'a') {
             player.cursor_pos.x = std::max(0, player.cursor_pos.x - 1);
-        } else if (c == 'd') {
+        } else if (event.key == Key::Right || c == 'd') {
             player.cursor_pos.x = std::min(width - 1, player.cursor_pos.x + 1);
-        } else if (c == 'w') {
+        } else if (event.key == Key::Up || c == 'w') {
             player.cursor_pos.y = std::max(0, player.cursor_pos.y - 1);
-        } else if (c == 's') {
+        } else if (event.key == Key::Down || c == 's') {
             player.cursor_pos.y = std::min(height - 1, player.cursor_pos.y + 1);
         } else if (c == 'f') {
             player.create_path();
-        } else if (c == '\r') {
-            player.new_action();
+        } else if (event.key == Key::Enter) {
+            open_action = true;
+        } else if (c == 'q') {
+            quit = true;
         }
-        c = engine.get_no_wait();
     }
     if (old_cursor_pos != player.cursor_pos) {
         map[old_cursor_pos.y][old_cursor_pos.x].is_selected = false;
@@ -325,6 +346,8 @@ void Map::get_player_control() {
         redraw(old_cursor_pos.x, old_cursor_pos.y);
         redraw(player.cursor_pos.x, player.cursor_pos.y);
     }
+    if (open_action) player.new_action();
+    return has_input;
 }
 
 double Map::get_passability(int x, int y) {
@@ -380,7 +403,10 @@ std::vector<Buildings> Map::get_available_buildings(int x, int y){
 int Menu::show_options_menu(ConsoleEngine& engine, int width, int heigth,
                             int pos_x, int pos_y,
                             std::vector<MenuOption> options) {
-    return Menu(engine, width, heigth, pos_x, pos_y, options).get_option();
+    Menu menu(engine, width, heigth, pos_x, pos_y, options);
+    int option = menu.get_option();
+    menu.close();
+    return option;
 }
 Menu::Menu(ConsoleEngine& engine, int width, int height, int pos_x, int pos_y,
            std::vector<MenuOption> options)
@@ -390,78 +416,78 @@ Menu::Menu(ConsoleEngine& engine, int width, int height, int pos_x, int pos_y,
       pos_y(pos_y),
       height(height),
       options(options),
-      current_option(0) {}
+      current_option(0),
+      covered(engine.save_region(pos_x, pos_y, width, height)) {}
 
-void Menu::set_relative_pos(int x, int y) {
-    engine.set_cursor_to_pos(pos_x + x, pos_y + y);
+void Menu::print_relative(int x, int y, std::string_view text,
+                          ConsoleCell style) {
+    engine.draw_text(pos_x + x, pos_y + y, text, style);
 }
 
 void Menu::draw() {
-    for (int x = 0; x < width; ++x) {
-        set_relative_pos(x, 0);
-        engine.print('#');
-    }
-    for (int x = 0; x < width; ++x) {
-        set_relative_pos(x, height - 1);
-        engine.print('#');
-    }
-    for (int y = 0; y < height; ++y) {
-        set_relative_pos(0, y);
-        engine.print('#');
-    }
-    for (int y = 0; y < height; ++y) {
-        set_relative_pos(width - 1, y);
-        engine.print('#');
-    }
-    for (int y = 1; y < height - 1; ++y) {
-        set_relative_pos(1, y);
-        engine.print(std::string(width - 2, ' '));
-    }
+    engine.draw_rect(pos_x, pos_y, width, height, '#');
+    engine.fill_rect(pos_x + 1, pos_y + 1, width - 2, height - 2, ' ');
     for (int option = 0; option < options.size(); ++option) {
-        set_relative_pos((width - 2 - options[option].param.size()) / 2, option + 1);
-        if (option == current_option)
-            engine.set_background_color(Colors256::Gray50);
-        engine.print(options[option].param);
-        if (option == current_option) engine.reset_styles();
+        draw_option(option);
     }
+    engine.present();
+}
+void Menu::draw_option(int option) {
+    ConsoleCell style;
+    if (option == current_option)
+        style.set_background_color(Colors256::Gray50);
+    print_relative((width - 2 - options[option].param.size()) / 2,
+                   option + 1, options[option].param, style);
 }
 int Menu::get_option() {
     draw();
-    char c;
-    do {
-        c = engine.get_no_wait();
-        if (c == 'w') {
+    KeyEvent event;
+    // Пока меню открыто, поток спит до нажатия клавиши
+    while (engine.wait_event(event)) {
+        char c = event.key == Key::Char ? event.ch : '\0';
+        if (event.key == Key::Up || c == 'w') {
             select_option(current_option - 1);
-        } else if (c == 's') {
+        } else if (event.key == Key::Down || c == 's') {
             select_option(current_option + 1);
-        } else if (c == '\r') {
+        } else if (event.key == Key::Enter) {
             return current_option;
-        } else if (c == 27) {
+        } else if (event.key == Key::Escape) {
             return -1;
         }
-    } while (true);
-    return 0;
+    }
+    // Ввод закончился - как отмена; саму игру остановит play()
+    return -1;
+}
+void Menu::close() {
+    engine.restore_region(covered);
+    engine.present();
 }
 void Menu::select_option(int option) {
     option = std::max(0, std::min((int)options.size() - 1, option));
     if (option == current_option) return;
-    set_relative_pos((width - 2 - options[current_option].param.size()) / 2,
-                     current_option + 1);
-    engine.print(options[current_option].param);
-
+    int previous_option = current_option;
     current_option = option;
-
-    engine.set_background_color(Colors256::Gray50);
-    set_relative_pos((width - 2 - options[current_option].param.size()) / 2,
-                     current_option + 1);
-    engine.print(options[current_option].param);
-    engine.reset_styles();
+    draw_option(previous_option);
+    draw_option(current_option);
+    engine.present();
 }
 
 MyGarden::MyGarden(int width, int height) : map(width, height) {}
 void MyGarden::play() {
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        map.update();
-    }
+    GameLoop loop(std::chrono::milliseconds(100),
+                  std::chrono::milliseconds(16));
+    auto render = [&] {
+        map.engine.stats().add_update_time(loop.update_time());
+        map.render();
+    };
+    loop.set_wait([this](GameLoop::Clock::time_point deadline) {
+        map.engine.wait_input(deadline);
+    });
+    auto input = [&] {
+        bool has_input = map.handle_input();
+        // Без ввода (stdin закрыт) играть некому
+        if (map.quit_requested() || map.engine.input_closed()) loop.stop();
+        return has_input;
+    };
+    loop.run(input, [this] { map.update(); }, render);
 }
\ No newline at end of file
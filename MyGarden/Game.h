@@ -12,6 +12,7 @@
 #include <any>
 
 #include "ConsoleEngine.h"
+#include "GameLoop.h"
 #include "GameObjects.h"
 #include "RandomGenerator.h"
 #include "Point.h"
@@ -36,7 +37,13 @@ class Map {
   public:
     Map(int width, int height);
     Cell& get(int x, int y);
+    // true, если игрок что-то нажал
+    bool handle_input();
+    // Игрок нажал q: игра заканчивается, и движок успевает сохранить
+    // статистику и запись кадров
+    bool quit_requested() const { return quit; }
     void update();
+    void render();
     double get_passability(int x, int y);
     double get_passability(Point p);
 
@@ -52,6 +59,10 @@ class Map {
     std::vector<PlayerActionTypes> get_available_action(int x, int y);
     std::vector<Buildings> get_available_buildings(int x, int y);
 
+    // Часть карты, которая помещается в окно терминала
+    int visible_width();
+    int visible_height();
+
     int width;
     int height;
 
@@ -60,6 +71,7 @@ class Map {
   private:
     std::vector<std::vector<Cell>> map;
     Player player;
+    bool quit = false;
 
     void generate();
     void generate_lakes();
@@ -68,7 +80,7 @@ class Map {
     void generate_objects();
     void add_gardener();
 
-    void get_player_control();
+    bool get_player_control();
     void player_move();
 };
 
@@ -87,9 +99,12 @@ class Menu {
     Menu(ConsoleEngine& engine, int width, int height, int pos_x, int pos_y,
          std::vector<MenuOption> options);
     void draw();
+    void draw_option(int option);
     int get_option();
+    void close();
     void select_option(int option);
-    void set_relative_pos(int x, int y);
+    void print_relative(int x, int y, std::string_view text,
+                        ConsoleCell style = ConsoleCell());
     ConsoleEngine& engine;
     int width;
     int height;
@@ -97,6 +112,8 @@ class Menu {
     int pos_y;
     std::vector<MenuOption> options;
     int current_option;
+    // Что было под меню - возвращается при закрытии
+    SavedRegion covered;
 };
 
 class MyGarden {
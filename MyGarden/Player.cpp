@@ -86,10 +86,9 @@ void Player::new_action() {
         menu_options.emplace_back(action_to_string(action), action);
     }
 
-    int chose =
-        Menu::show_options_menu(map.engine, 20, 10, (map.width - 20) / 2,
-                                (map.height - 10) / 2, menu_options);
-    map.redraw_all();
+    int chose = Menu::show_options_menu(
+        map.engine, 20, 10, (map.visible_width() - 20) / 2,
+        (map.visible_height() - 10) / 2, menu_options);
 
     if (chose < 0) return;  // TODO: исправить на optional
     PlayerActionTypes chosed =
@@ -98,10 +97,10 @@ void Player::new_action() {
         create_path();
     } else if (chosed == PlayerActionTypes::Place) {
         int chose_object = Menu::show_options_menu(
-            map.engine, 20, 10, (map.width - 20) / 2, (map.height - 10) / 2,
+            map.engine, 20, 10, (map.visible_width() - 20) / 2,
+            (map.visible_height() - 10) / 2,
             {{"Flower", 0},
              {"Tree", 1}});
-        map.redraw_all();
         if (chose_object < 0) return;
         create_path_to_area();
         if (chose_object == 0)
@@ -120,9 +119,9 @@ void Player::new_action() {
         }
 
         int chose_object_ind = Menu::show_options_menu(
-            map.engine, 20, 10, (map.width - 20) / 2, (map.height - 10) / 2,
+            map.engine, 20, 10, (map.visible_width() - 20) / 2,
+            (map.visible_height() - 10) / 2,
             menu_buildings_options);
-        map.redraw_all();
         if (chose_object_ind < 0) return;
         Buildings chose_object =
             std::any_cast<Buildings>(menu_buildings_options[chose_object_ind].return_param);
@@ -0,0 +1,485 @@
+#include "AnsiEncoder.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "AnsiTables.h"
+
+namespace {
+constexpr uint8_t style_attrs =
+    CellAttrs::Bold | CellAttrs::Underline | CellAttrs::Inverse;
+
+bool same_style(const ConsoleCell& a, const ConsoleCell& b) {
+    if (a.attrs != b.attrs) return false;
+    if ((a.attrs & CellAttrs::TextColor) && a.fg != b.fg) return false;
+    if ((a.attrs & CellAttrs::BkgColor) && a.bg != b.bg) return false;
+    return true;
+}
+
+int digits(int n) {
+    int count = 1;
+    while (n >= 10) {
+        n /= 10;
+        ++count;
+    }
+    return count;
+}
+
+void append_number(std::string& out, int n) {
+    char buf[16];
+    auto result = std::to_chars(buf, buf + sizeof(buf), n);
+    out.append(buf, result.ptr);
+}
+
+// Длина "\033[nX"; для n = 1 число можно не писать
+int relative_cost(int n) {
+    if (n == 0) return 0;
+    return n == 1 ? 3 : 3 + digits(n);
+}
+
+void add_relative(std::string& out, int n, char forward, char backward) {
+    if (n == 0) return;
+    out += "\033[";
+    if (std::abs(n) != 1) append_number(out, std::abs(n));
+    out += n > 0 ? forward : backward;
+}
+
+int absolute_cost(int x, int y) {
+    if (x == 0 && y == 0) return 3;
+    if (x == 0) return 3 + digits(y + 1);
+    return 4 + digits(y + 1) + digits(x + 1);
+}
+
+void add_absolute(std::string& out, int x, int y) {
+    out += "\033[";
+    if (x != 0 || y != 0) append_number(out, y + 1);
+    if (x != 0) {
+        out += ';';
+        append_number(out, x + 1);
+    }
+    out += 'H';
+}
+}  // namespace
+
+void AnsiEncoder::Params::add(std::string_view param) {
+    if (size > 0) data[size++] = ';';
+    std::memcpy(data + size, param.data(), param.size());
+    size += param.size();
+}
+
+int AnsiEncoder::encode_frame(std::string& out, const FrameBuffer& frame,
+                              FrameBuffer& screen, std::size_t byte_budget) {
+    if (screen.width() != frame.width() || screen.height() != frame.height())
+        screen.resize(frame.width(), frame.height(), FrameBuffer::unknown_cell);
+    ColorDepth reduced = depth_;
+    if (depth_ != max_depth_) {
+        if (byte_budget == SIZE_MAX) {
+            // Канал снова быстрый - перерисовываем всё в полном цвете
+            depth_ = max_depth_;
+            screen.fill(FrameBuffer::unknown_cell);
+        } else if (++calm_frames_ >= calm_frames_to_upgrade) {
+            depth_ = ColorDepth(int(depth_) + 1);
+            calm_frames_ = 0;
+        }
+    }
+    if (byte_budget == SIZE_MAX) return encode(out, frame, screen);
+
+    std::size_t start = out.size();
+    Snapshot saved = snapshot();
+    journal_.clear();
+    journaling_ = true;
+    // Ячейки, выведенные беднее, перерисуются в новых цветах. Если кадр
+    // тогда не влезет, откат вернет их вместе с остальным screen
+    if (depth_ != reduced) repaint_reduced(screen, reduced);
+    while (true) {
+        int changed = encode(out, frame, screen);
+        std::size_t bytes = out.size() - start;
+        if (bytes > byte_budget / 4) calm_frames_ = 0;
+        // Монохромный кадр уже не сократить, он уходит как есть
+        if (bytes <= byte_budget || depth_ == ColorDepth::Mono) {
+            journaling_ = false;
+            return changed;
+        }
+        rollback(saved, screen);
+        depth_ = ColorDepth(int(depth_) - 1);
+        calm_frames_ = 0;
+        out.resize(start);
+    }
+}
+
+AnsiEncoder::Snapshot AnsiEncoder::snapshot() const {
+    return {style_,    style_known_,  style_id_, cursor_x_,
+            cursor_y_, cursor_known_, scroll_};
+}
+
+void AnsiEncoder::rollback(const Snapshot& saved, FrameBuffer& screen) {
+    // С конца: прокрутка могла записать ячейку раньше, чем ее вывели
+    for (auto it = journal_.rbegin(); it != journal_.rend(); ++it)
+        screen.at(it->x, it->y) = it->cell;
+    journal_.clear();
+    style_ = saved.style;
+    style_known_ = saved.style_known;
+    style_id_ = saved.style_id;
+    cursor_x_ = saved.cursor_x;
+    cursor_y_ = saved.cursor_y;
+    cursor_known_ = saved.cursor_known;
+    scroll_ = saved.scroll;
+}
+
+void AnsiEncoder::remember(const FrameBuffer& screen, int x, int y) {
+    if (journaling_) journal_.push_back({x, y, screen.at(x, y)});
+}
+
+void AnsiEncoder::repaint_reduced(FrameBuffer& screen, ColorDepth reduced) {
+    for (int y = 0; y < screen.height(); ++y) {
+        for (int x = 0; x < screen.width(); ++x) {
+            ConsoleCell& cell = screen.at(x, y);
+            if (cell == FrameBuffer::unknown_cell ||
+                same_style(with_depth(cell, reduced), with_depth(cell, depth_)))
+                continue;
+            remember(screen, x, y);
+            cell = FrameBuffer::unknown_cell;
+        }
+    }
+}
+
+void AnsiEncoder::set_color_depth(ColorDepth depth) {
+    max_depth_ = depth_ = depth;
+    calm_frames_ = 0;
+}
+
+int AnsiEncoder::encode(std::string& out, const FrameBuffer& frame,
+                        FrameBuffer& screen) {
+    int width = std::min(frame.width(), viewport_width_);
+    int height = std::min(frame.height(), viewport_height_);
+    std::size_t start = out.size();
+    if (synchronized_) out += "\033[?2026h";
+    std::size_t body = out.size();
+    apply_scroll(out, frame, screen, width, height);
+    int changed = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const ConsoleCell& cell = frame.at(x, y);
+            if (cell == screen.at(x, y)) continue;
+            move_cursor(out, x, y, screen);
+            set_style(out, cell);
+            out += cell.glyph;
+            cursor_advanced(width);
+            remember(screen, x, y);
+            screen.at(x, y) = cell;
+            ++changed;
+        }
+    }
+    // Пустой кадр не стоит того, чтобы терминал его синхронизировал
+    bool empty = out.size() == body;
+    if (empty) out.resize(start);
+    // Обычный вывод после кадра не должен унаследовать цвета
+    reset_style(out);
+    if (synchronized_ && !empty) out += "\033[?2026l";
+    return changed;
+}
+
+void AnsiEncoder::request_scroll(int top, int bottom, int lines) {
+    if (scroll_.top != top || scroll_.bottom != bottom) scroll_ = {top, bottom};
+    scroll_.lines += lines;
+}
+
+void AnsiEncoder::apply_scroll(std::string& out, const FrameBuffer& frame,
+                               FrameBuffer& screen, int width, int height) {
+    Scroll scroll = std::exchange(scroll_, Scroll());
+    int top = scroll.top, bottom = scroll.bottom, lines = scroll.lines;
+    // Область должна целиком быть видна, а часть строк - пережить сдвиг
+    if (lines == 0 || top < 0 || bottom > height ||
+        std::abs(lines) >= bottom - top)
+        return;
+
+    // Сколько ячеек пришлось бы вывести без прокрутки и после нее.
+    // Открывшиеся строки терминал заполняет пробелами
+    int redraw = 0, scrolled = 0;
+    for (int y = top; y < bottom; ++y) {
+        int from = y + lines;
+        bool exposed = from < top || from >= bottom;
+        for (int x = 0; x < width; ++x) {
+            const ConsoleCell& cell = frame.at(x, y);
+            redraw += cell != screen.at(x, y);
+            scrolled += cell != (exposed ? ConsoleCell() : screen.at(x, from));
+        }
+    }
+    if (scrolled + scroll_cost >= redraw) return;
+
+    // Новые строки получают текущий фон, поэтому сначала сброс
+    reset_style(out);
+    out += "\033[";
+    append_number(out, top + 1);
+    out += ';';
+    append_number(out, bottom);
+    out += 'r';
+    add_relative(out, lines, 'S', 'T');
+    // Возвращаем область на весь экран; DECSTBM ставит курсор в начало
+    out += "\033[r";
+    cursor_moved_to(0, 0);
+    if (journaling_) {
+        for (int y = top; y < bottom; ++y)
+            for (int x = 0; x < screen.width(); ++x) remember(screen, x, y);
+    }
+    screen.scroll(top, bottom, lines, ConsoleCell());
+    // Что за правым краем окна, по-прежнему неизвестно
+    int exposed_top = lines > 0 ? bottom - lines : top;
+    screen.fill_rect(width, exposed_top, screen.width() - width,
+                     std::abs(lines), FrameBuffer::unknown_cell);
+}
+
+void AnsiEncoder::set_viewport(int width, int height, FrameBuffer& screen) {
+    viewport_width_ = width > 0 ? width : INT_MAX;
+    viewport_height_ = height > 0 ? height : INT_MAX;
+    for (int y = 0; y < screen.height(); ++y) {
+        for (int x = 0; x < screen.width(); ++x) {
+            if (x >= viewport_width_ || y >= viewport_height_)
+                screen.at(x, y) = FrameBuffer::unknown_cell;
+        }
+    }
+    forget_cursor();
+}
+
+ConsoleCell AnsiEncoder::with_depth(ConsoleCell cell, ColorDepth depth) {
+    switch (depth) {
+        case ColorDepth::Ansi256:
+            break;
+        case ColorDepth::Ansi16:
+            cell.fg = AnsiTables::nearest16[cell.fg.id];
+            cell.bg = AnsiTables::nearest16[cell.bg.id];
+            break;
+        case ColorDepth::Mono:
+            // Выделение фоном (пункт меню) должно остаться заметным
+            if ((cell.attrs & CellAttrs::BkgColor) &&
+                AnsiTables::nearest16[cell.bg.id] != 0)
+                cell.attrs |= CellAttrs::Inverse;
+            cell.attrs &= ~(CellAttrs::TextColor | CellAttrs::BkgColor);
+            cell.fg = cell.bg = 0;
+            break;
+    }
+    return cell;
+}
+
+std::string_view AnsiEncoder::text_color(Color256 color) const {
+    if (depth_ == ColorDepth::Ansi16)
+        return AnsiTables::text_colors16[color.id].view();
+    return AnsiTables::text_color(color);
+}
+
+std::string_view AnsiEncoder::background_color(Color256 color) const {
+    if (depth_ == ColorDepth::Ansi16)
+        return AnsiTables::background_colors16[color.id].view();
+    return AnsiTables::background_color(color);
+}
+
+std::string_view AnsiEncoder::text_color_param(Color256 color) const {
+    if (depth_ == ColorDepth::Mono) return "";
+    return text_color(color);
+}
+
+std::string_view AnsiEncoder::background_color_param(Color256 color) const {
+    if (depth_ != ColorDepth::Mono) return background_color(color);
+    // Как и в кадре: выделение фоном должно остаться заметным
+    if (AnsiTables::nearest16[color.id] == 0) return "";
+    return AnsiTables::param(ConsoleStyle::Inverse);
+}
+
+std::string_view AnsiEncoder::text_color_param(ConsoleTextColors color) const {
+    if (depth_ == ColorDepth::Mono) return "";
+    return AnsiTables::param(color);
+}
+
+std::string_view AnsiEncoder::background_color_param(
+    ConsoleBkgColors color) const {
+    if (depth_ != ColorDepth::Mono) return AnsiTables::param(color);
+    if (color == ConsoleBkgColors::Black) return "";
+    return AnsiTables::param(ConsoleStyle::Inverse);
+}
+
+ConsoleCell AnsiEncoder::visible_style(const ConsoleCell& cell) const {
+    ConsoleCell target = with_depth(cell, depth_);
+    // У пробела без подчеркивания и инверсии цвет текста и жирность не видны,
+    // их можно оставить как есть
+    bool blank = cell.glyph == ' ' &&
+                 !(cell.attrs & (CellAttrs::Underline | CellAttrs::Inverse));
+    if (style_known_ && blank) {
+        constexpr uint8_t invisible = CellAttrs::TextColor | CellAttrs::Bold;
+        target.attrs =
+            (target.attrs & ~invisible) | (style_.attrs & invisible);
+        target.fg = style_.fg;
+    }
+    return target;
+}
+
+bool AnsiEncoder::style_matches(const ConsoleCell& cell) const {
+    return style_known_ && same_style(style_, visible_style(cell));
+}
+
+void AnsiEncoder::set_style(std::string& out, const ConsoleCell& cell) {
+    ConsoleCell target = visible_style(cell);
+    if (style_known_ && same_style(style_, target)) return;
+
+    int from = style_known_ ? style_id_ : StyleCache::unknown;
+    int to = styles_.intern(target, depth_);
+    bool cacheable = from >= 0 && to >= 0;
+    std::string_view cached = cacheable ? styles_.find(from, to) : "";
+    if (!cached.empty()) {
+        out += cached;
+    } else {
+        Params params;
+        append_full(params, target);
+        if (style_known_) {
+            Params delta;
+            append_delta(delta, target);
+            if (delta.size < params.size) params = delta;
+        }
+        std::size_t start = out.size();
+        out += "\033[";
+        out += params.view();
+        out += 'm';
+        if (cacheable)
+            styles_.store(from, to, std::string_view(out).substr(start));
+    }
+    style_ = target;
+    style_known_ = true;
+    style_id_ = to;
+}
+
+void AnsiEncoder::reset_style(std::string& out) {
+    if (is_default_style()) return;
+    out += "\033[0m";
+    style_was_reset();
+}
+
+void AnsiEncoder::style_was_reset() {
+    style_ = ConsoleCell();
+    style_known_ = true;
+    style_id_ = styles_.intern(style_, depth_);
+}
+
+void AnsiEncoder::forget_style() { style_known_ = false; }
+
+bool AnsiEncoder::is_default_style() const {
+    return style_known_ && same_style(style_, ConsoleCell());
+}
+
+void AnsiEncoder::append_full(Params& params, const ConsoleCell& cell) const {
+    params.add(AnsiTables::param(ConsoleStyle::Reset));
+    if (cell.attrs & CellAttrs::Bold)
+        params.add(AnsiTables::param(ConsoleStyle::Bold));
+    if (cell.attrs & CellAttrs::Underline)
+        params.add(AnsiTables::param(ConsoleStyle::Underline));
+    if (cell.attrs & CellAttrs::Inverse)
+        params.add(AnsiTables::param(ConsoleStyle::Inverse));
+    if (cell.attrs & CellAttrs::TextColor)
+        params.add(text_color(cell.fg));
+    if (cell.attrs & CellAttrs::BkgColor)
+        params.add(background_color(cell.bg));
+}
+
+void AnsiEncoder::append_delta(Params& params, const ConsoleCell& cell) const {
+    uint8_t turned_off = style_.attrs & ~cell.attrs & style_attrs;
+    uint8_t turned_on = cell.attrs & ~style_.attrs & style_attrs;
+    if (turned_off & CellAttrs::Bold) params.add("22");
+    if (turned_off & CellAttrs::Underline) params.add("24");
+    if (turned_off & CellAttrs::Inverse) params.add("27");
+    if (turned_on & CellAttrs::Bold)
+        params.add(AnsiTables::param(ConsoleStyle::Bold));
+    if (turned_on & CellAttrs::Underline)
+        params.add(AnsiTables::param(ConsoleStyle::Underline));
+    if (turned_on & CellAttrs::Inverse)
+        params.add(AnsiTables::param(ConsoleStyle::Inverse));
+
+    if (cell.attrs & CellAttrs::TextColor) {
+        if (!(style_.attrs & CellAttrs::TextColor) || style_.fg != cell.fg)
+            params.add(text_color(cell.fg));
+    } else if (style_.attrs & CellAttrs::TextColor) {
+        params.add("39");
+    }
+    if (cell.attrs & CellAttrs::BkgColor) {
+        if (!(style_.attrs & CellAttrs::BkgColor) || style_.bg != cell.bg)
+            params.add(background_color(cell.bg));
+    } else if (style_.attrs & CellAttrs::BkgColor) {
+        params.add("49");
+    }
+}
+
+void AnsiEncoder::move_cursor(std::string& out, int x, int y,
+                              const FrameBuffer& screen) {
+    if (cursor_known_ && cursor_x_ == x && cursor_y_ == y) return;
+
+    enum class Move { Absolute, Relative, CarriageReturn, LineFeed, Overprint };
+    Move best = Move::Absolute;
+    int best_cost = absolute_cost(x, y);
+    auto consider = [&](Move move, int cost) {
+        if (cost < best_cost) {
+            best = move;
+            best_cost = cost;
+        }
+    };
+    int dx = x - cursor_x_;
+    int dy = y - cursor_y_;
+    if (cursor_known_) {
+        consider(Move::Relative, relative_cost(dy) + relative_cost(dx));
+        consider(Move::CarriageReturn,
+                 1 + relative_cost(dy) + relative_cost(x));
+        // "\r\n" ведет в начало следующей строки при любых настройках ONLCR
+        if (dy > 0) consider(Move::LineFeed, 1 + dy + relative_cost(x));
+        if (dy == 0 && dx > 0 && dx <= max_overprint &&
+            can_overprint(y, cursor_x_, x, screen))
+            consider(Move::Overprint, dx);
+    }
+
+    switch (best) {
+        case Move::Absolute:
+            add_absolute(out, x, y);
+            break;
+        case Move::Relative:
+            add_relative(out, dy, 'B', 'A');
+            add_relative(out, dx, 'C', 'D');
+            break;
+        case Move::CarriageReturn:
+            out += '\r';
+            add_relative(out, dy, 'B', 'A');
+            add_relative(out, x, 'C', 'D');
+            break;
+        case Move::LineFeed:
+            out += '\r';
+            out.append(dy, '\n');
+            add_relative(out, x, 'C', 'D');
+            break;
+        case Move::Overprint:
+            for (int i = cursor_x_; i < x; ++i) out += screen.at(i, y).glyph;
+            break;
+    }
+    cursor_moved_to(x, y);
+}
+
+bool AnsiEncoder::can_overprint(int y, int from_x, int to_x,
+                                const FrameBuffer& screen) const {
+    if (!screen.contains(from_x, y) || !screen.contains(to_x - 1, y))
+        return false;
+    for (int x = from_x; x < to_x; ++x) {
+        const ConsoleCell& cell = screen.at(x, y);
+        if (cell == FrameBuffer::unknown_cell || !style_matches(cell))
+            return false;
+    }
+    return true;
+}
+
+void AnsiEncoder::cursor_advanced(int screen_width) {
+    if (!cursor_known_) return;
+    if (++cursor_x_ >= screen_width) cursor_known_ = false;
+}
+
+void AnsiEncoder::cursor_moved_to(int x, int y) {
+    cursor_x_ = x;
+    cursor_y_ = y;
+    cursor_known_ = true;
+}
+
+void AnsiEncoder::forget_cursor() { cursor_known_ = false; }
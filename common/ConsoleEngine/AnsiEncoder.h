@@ -0,0 +1,146 @@
+#pragma once
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FrameBuffer.h"
+#include "StyleCache.h"
+
+// Помнит, какое оформление сейчас установлено в терминале и где стоит
+// курсор. При смене ячейки выводит только отличающиеся параметры SGR одной
+// последовательностью, а курсор двигает самым коротким способом
+class AnsiEncoder {
+  public:
+    // Выводит ячейки frame, отличающиеся от screen, и обновляет screen.
+    // Возвращает число выведенных ячеек. Если кадр не влезает в
+    // byte_budget, он кодируется заново с меньшим числом цветов (вплоть до
+    // монохромного); когда канал снова успевает, цвета возвращаются
+    int encode_frame(std::string& out, const FrameBuffer& frame,
+                     FrameBuffer& screen, std::size_t byte_budget = SIZE_MAX);
+    // Больше цветов, чем понимает терминал, не выводится никогда
+    void set_color_depth(ColorDepth depth);
+    ColorDepth color_depth() const { return depth_; }
+    // Видимая часть экрана - окно терминала. Ячейки за его пределами не
+    // выводятся, иначе строки перенесутся. Что было за новыми границами,
+    // в screen становится неизвестным и перерисуется, когда снова откроется
+    void set_viewport(int width, int height, FrameBuffer& screen);
+    // Обрамлять непустой кадр режимом синхронного вывода (DEC 2026):
+    // терминал копит его и показывает целиком. Кто режим не знает, просто
+    // игнорирует эти последовательности
+    void set_synchronized(bool enabled) { synchronized_ = enabled; }
+    bool synchronized() const { return synchronized_; }
+    // Содержимое строк [top, bottom) сдвинулось на lines вверх (lines < 0 -
+    // вниз). Следующий encode_frame прокрутит эту область в терминале
+    // (DECSTBM + SU/SD), если так выйдет меньше ячеек, чем перерисовка.
+    // Подсказки до кадра складываются; другая область заменяет прежнюю
+    void request_scroll(int top, int bottom, int lines);
+    void set_style(std::string& out, const ConsoleCell& cell);
+    void reset_style(std::string& out);
+    // screen - то, что сейчас показано в терминале; его ячейки можно
+    // перепечатать вместо перемещения курсора
+    void move_cursor(std::string& out, int x, int y,
+                     const FrameBuffer& screen);
+    // Курсор сдвинулся после вывода символа. У правого края терминал может
+    // не перенести курсор сразу, поэтому там позиция становится неизвестной
+    void cursor_advanced(int screen_width);
+    void cursor_moved_to(int x, int y);
+    void forget_cursor();
+
+    // Терминал сбросил оформление сам (например, после "\033[0m")
+    void style_was_reset();
+    // Оформление в терминале неизвестно - следующая смена пойдет с нуля
+    void forget_style();
+    bool is_default_style() const;
+    // Параметр SGR для цвета вне кадров (set_text_color, print_color) при
+    // текущей глубине. В монохроме цвета нет, фон заменяется инверсией;
+    // пустая строка - выводить нечего
+    std::string_view text_color_param(Color256 color) const;
+    std::string_view background_color_param(Color256 color) const;
+    std::string_view text_color_param(ConsoleTextColors color) const;
+    std::string_view background_color_param(ConsoleBkgColors color) const;
+
+  private:
+    // Дальше перепечатка ячеек обходится дороже любой последовательности
+    static constexpr int max_overprint = 8;
+    // Столько кадров подряд должно уложиться в четверть бюджета, чтобы
+    // вернуть цвета - иначе глубина будет прыгать туда-сюда
+    static constexpr int calm_frames_to_upgrade = 30;
+    // Примерная длина прокрутки в ячейках: "\033[3;22r\033[T\033[r"
+    static constexpr int scroll_cost = 16;
+
+    struct Scroll {
+        int top = 0;
+        int bottom = 0;
+        int lines = 0;
+    };
+
+    // Состояние, которое меняет кодирование кадра. Таблица переходов
+    // styles_ сюда не входит: ее записи верны при любом исходе
+    struct Snapshot {
+        ConsoleCell style;
+        bool style_known = false;
+        int style_id = -1;
+        int cursor_x = 0;
+        int cursor_y = 0;
+        bool cursor_known = false;
+        Scroll scroll;
+    };
+    // Прежнее содержимое ячейки screen, которую переписал кадр
+    struct ScreenChange {
+        int x = 0;
+        int y = 0;
+        ConsoleCell cell;
+    };
+
+    // Параметры одной последовательности SGR без выделения памяти. Самая
+    // длинная: "22;24;27;38;5;255;48;5;255"
+    struct Params {
+        char data[32];
+        int size = 0;
+
+        void add(std::string_view param);
+        std::string_view view() const { return {data, std::size_t(size)}; }
+    };
+
+    ConsoleCell style_;
+    bool style_known_ = false;
+    // Номер style_ в styles_, -1 - не попал в таблицу
+    int style_id_ = -1;
+    StyleCache styles_;
+    int cursor_x_ = 0;
+    int cursor_y_ = 0;
+    bool cursor_known_ = false;
+    int viewport_width_ = INT_MAX;
+    int viewport_height_ = INT_MAX;
+    bool synchronized_ = false;
+    Scroll scroll_;
+    ColorDepth max_depth_ = ColorDepth::Ansi256;
+    ColorDepth depth_ = ColorDepth::Ansi256;
+    int calm_frames_ = 0;
+    // Пока кадр может не уложиться в бюджет, изменения screen записываются,
+    // чтобы откатить их без копии всего экрана
+    bool journaling_ = false;
+    std::vector<ScreenChange> journal_;
+
+    int encode(std::string& out, const FrameBuffer& frame,
+               FrameBuffer& screen);
+    Snapshot snapshot() const;
+    void rollback(const Snapshot& saved, FrameBuffer& screen);
+    void remember(const FrameBuffer& screen, int x, int y);
+    static ConsoleCell with_depth(ConsoleCell cell, ColorDepth depth);
+    void repaint_reduced(FrameBuffer& screen, ColorDepth reduced);
+    std::string_view text_color(Color256 color) const;
+    std::string_view background_color(Color256 color) const;
+    ConsoleCell visible_style(const ConsoleCell& cell) const;
+    bool style_matches(const ConsoleCell& cell) const;
+    bool can_overprint(int y, int from_x, int to_x,
+                       const FrameBuffer& screen) const;
+    void apply_scroll(std::string& out, const FrameBuffer& frame,
+                      FrameBuffer& screen, int width, int height);
+
+    void append_full(Params& params, const ConsoleCell& cell) const;
+    void append_delta(Params& params, const ConsoleCell& cell) const;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "ConsoleColors.h"
+
+// Заранее закодированные параметры SGR. Цветов всего 256, поэтому проще
+// один раз собрать все строки на этапе компиляции, чем каждый раз
+// форматировать числа через поток
+namespace AnsiTables {
+
+struct Sequence {
+    char data[12]{};
+    uint8_t size = 0;
+
+    constexpr void append(std::string_view s) {
+        for (char c : s) data[size++] = c;
+    }
+    constexpr void append_number(int n) {
+        char digits[3]{};
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        while (count > 0) data[size++] = digits[--count];
+    }
+    constexpr std::string_view view() const { return {data, size}; }
+};
+
+constexpr std::array<Sequence, 256> make_table(std::string_view prefix) {
+    std::array<Sequence, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        table[i].append(prefix);
+        table[i].append_number(i);
+    }
+    return table;
+}
+
+// "0".."255" - для ConsoleStyle, ConsoleTextColors и ConsoleBkgColors
+inline constexpr std::array<Sequence, 256> numbers = make_table("");
+// "38;5;N" и "48;5;N" для Color256
+inline constexpr std::array<Sequence, 256> text_colors = make_table("38;5;");
+inline constexpr std::array<Sequence, 256> background_colors =
+    make_table("48;5;");
+
+constexpr std::string_view param(ConsoleStyle style) {
+    return numbers[static_cast<int>(style)].view();
+}
+constexpr std::string_view param(ConsoleTextColors color) {
+    return numbers[static_cast<int>(color)].view();
+}
+constexpr std::string_view param(ConsoleBkgColors color) {
+    return numbers[static_cast<int>(color)].view();
+}
+constexpr std::string_view text_color(Color256 color) {
+    return text_colors[color.id].view();
+}
+constexpr std::string_view background_color(Color256 color) {
+    return background_colors[color.id].view();
+}
+
+// Палитра xterm: 16 базовых цветов, куб 6x6x6 и 24 оттенка серого
+struct Rgb {
+    int r, g, b;
+};
+
+constexpr Rgb xterm_rgb(int id) {
+    constexpr Rgb basic[16] = {
+        {0, 0, 0},       {205, 0, 0},   {0, 205, 0},     {205, 205, 0},
+        {0, 0, 238},     {205, 0, 205}, {0, 205, 205},   {229, 229, 229},
+        {127, 127, 127}, {255, 0, 0},   {0, 255, 0},     {255, 255, 0},
+        {92, 92, 255},   {255, 0, 255}, {0, 255, 255},   {255, 255, 255}};
+    if (id < 16) return basic[id];
+    if (id >= 232) {
+        int level = 8 + (id - 232) * 10;
+        return {level, level, level};
+    }
+    constexpr int levels[6] = {0, 95, 135, 175, 215, 255};
+    id -= 16;
+    return {levels[id / 36], levels[id / 6 % 6], levels[id % 6]};
+}
+
+constexpr std::array<uint8_t, 256> make_nearest16() {
+    std::array<uint8_t, 256> table{};
+    for (int id = 0; id < 256; ++id) {
+        Rgb color = xterm_rgb(id);
+        int best_distance = -1;
+        for (int basic = 0; basic < 16; ++basic) {
+            Rgb candidate = xterm_rgb(basic);
+            int dr = color.r - candidate.r;
+            int dg = color.g - candidate.g;
+            int db = color.b - candidate.b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (best_distance < 0 || distance < best_distance) {
+                best_distance = distance;
+                table[id] = static_cast<uint8_t>(basic);
+            }
+        }
+    }
+    return table;
+}
+
+// Color256 -> ближайший из 16 базовых цветов
+inline constexpr std::array<uint8_t, 256> nearest16 = make_nearest16();
+
+constexpr std::array<Sequence, 16> make_table16(int normal, int bright) {
+    std::array<Sequence, 16> table{};
+    for (int i = 0; i < 16; ++i)
+        table[i].append_number(i < 8 ? normal + i : bright + i - 8);
+    return table;
+}
+
+// "30".."37", "90".."97" и "40".."47", "100".."107" для цветов 0..15
+inline constexpr std::array<Sequence, 16> text_colors16 = make_table16(30, 90);
+inline constexpr std::array<Sequence, 16> background_colors16 =
+    make_table16(40, 100);
+
+static_assert(text_colors[196].view() == "38;5;196");
+static_assert(background_colors[7].view() == "48;5;7");
+static_assert(numbers[0].view() == "0");
+static_assert(nearest16[Colors256::Red.id] == 9);
+static_assert(nearest16[Colors256::White.id] == 15);
+static_assert(nearest16[4] == 4);
+static_assert(text_colors16[9].view() == "91");
+static_assert(background_colors16[8].view() == "100");
+
+}  // namespace AnsiTables
@@ -1,67 +1,517 @@
 #include "ConsoleEngine.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <utility>
 
-ConsoleEngine::ConsoleEngine() : ConsoleEngine(std::cin, std::cout) {}
+#include "AnsiTables.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+ConsoleEngine::ConsoleEngine() : ConsoleEngine(std::cin, std::cout) {
+#ifdef _WIN32
+    out_fd_ = 1;
+    in_fd_ = 0;
+#else
+    out_fd_ = STDOUT_FILENO;
+    in_fd_ = STDIN_FILENO;
+#endif
+    if (const char* path = std::getenv("CONSOLE_ENGINE_RECORD"))
+        record_path_ = path;
+    if (const char* path = std::getenv("CONSOLE_ENGINE_STATS"))
+        stats_->dump_on_exit(path);
+    if (std::getenv("CONSOLE_ENGINE_STATS_OVERLAY")) stats_overlay_ = true;
+    TerminalWindow::watch_resize();
+    update_terminal_size();
+    const char* sync = std::getenv("CONSOLE_ENGINE_SYNC");
+    bool sync_disabled = sync && std::string_view(sync) == "0";
+    set_synchronized_output(terminal_width() > 0 && !sync_disabled);
+    set_color_depth(TerminalWindow::color_depth());
+}
 ConsoleEngine::ConsoleEngine(std::istream& in, std::ostream& out)
     : cin_(in), cout_(out) {
     enableAnsiColors();
 }
 ConsoleEngine::~ConsoleEngine() {
+    stop_render_thread();
+    frame_depth_ = 0;
+    begin_frame();
     reset_styles();
     show_cursor();
-    cout_ << "\033[999B\n";
+    write("\033[999B\n");
+    end_frame();
     flush_input_buffer();
 }
 
-void ConsoleEngine::clear() { cout_ << "\033[2J\033[H" << std::flush; }
+void ConsoleEngine::clear() {
+    write("\033[2J\033[H");
+    flush();
+    front_.fill(ConsoleCell());
+    encoder_.cursor_moved_to(0, 0);
+}
 
-void ConsoleEngine::set_cursor_to_zero() { cout_ << "\033[H"; }
+void ConsoleEngine::set_cursor_to_zero() {
+    write("\033[H");
+    encoder_.cursor_moved_to(0, 0);
+}
 
 void ConsoleEngine::set_cursor_to_pos(int x, int y) {
-    cout_ << "\033[" << (y + 1) << ";" << (x + 1) << "H" << std::flush;
+    // Каждое число занимает не больше 11 символов
+    char buf[32] = "\033[";
+    char* end = std::to_chars(buf + 2, buf + 13, y + 1).ptr;
+    *end++ = ';';
+    end = std::to_chars(end, buf + 25, x + 1).ptr;
+    *end++ = 'H';
+    write(std::string_view(buf, end - buf));
+    flush();
+    encoder_.cursor_moved_to(x, y);
 }
 
-void ConsoleEngine::hide_cursor() { cout_ << "\033[?25l" << std::flush; }
-void ConsoleEngine::show_cursor() { cout_ << "\033[?25h" << std::flush; }
+void ConsoleEngine::hide_cursor() {
+    write("\033[?25l");
+    flush();
+}
+void ConsoleEngine::show_cursor() {
+    write("\033[?25h");
+    flush();
+}
 
 std::string ConsoleEngine::get() {
+    if (raw_session_) raw_session_->suspend();
     std::string input;
     std::getline(cin_, input);
-    cout_ << "\033[1A\033[2K\033[G" << std::flush;
+    write("\033[1A\033[2K\033[G");
+    flush();
+    encoder_.forget_cursor();
+    if (raw_session_) raw_session_->resume();
     return input;
 }
 
 char ConsoleEngine::get_no_wait() {
-    if (::uni_kbhit()) {
-        return ::uni_getch();
+    poll_input();
+    if (input_.empty()) return '\0';
+    return input_.pop();
+}
+
+std::string_view ConsoleEngine::drain_keys() {
+    keys_buf_.clear();
+    do {
+        while (!input_.empty()) keys_buf_ += input_.pop();
+        poll_input();
+    } while (!input_.empty());
+    return keys_buf_;
+}
+
+void ConsoleEngine::poll_input() {
+    if (in_fd_ >= 0) {
+        if (!input_closed_) read_terminal_input();
+        return;
+    }
+    char buf[decltype(input_)::capacity()];
+    std::streamsize count = cin_.readsome(buf, sizeof(buf));
+    on_input(buf, count);
+}
+
+void ConsoleEngine::on_input(const char* data, std::size_t count) {
+    auto now = KeyStateTable::Clock::now();
+    input_count_ += count;
+    for (std::size_t i = 0; i < count; ++i) {
+        // Если клавиши никто не забирает (игра смотрит только key_pressed),
+        // старые просто вытесняются
+        if (input_.full()) input_.pop();
+        input_.push(data[i]);
+        KeyEvent event;
+        if (parser_.feed(data[i], now, event)) on_event(event);
+    }
+}
+
+void ConsoleEngine::on_event(const KeyEvent& event) {
+    // Байты стрелок ("\033[A") не должны выглядеть как нажатие 'A'
+    if (event.ch != '\0') key_states_.press(event.ch, event.time);
+    stats_->add_keys(1);
+    if (events_.full()) events_.pop();
+    events_.push(event);
+}
+
+bool ConsoleEngine::poll_event(KeyEvent& event) {
+    poll_input();
+    KeyEvent escape;
+    // После конца ввода продолжения ESC ждать нечего
+    auto now = input_closed_ ? KeyEvent::Clock::time_point::max()
+                             : KeyEvent::Clock::now();
+    if (parser_.flush(now, escape)) on_event(escape);
+    if (events_.empty()) return false;
+    event = events_.pop();
+    return true;
+}
+
+bool ConsoleEngine::wait_event(KeyEvent& event,
+                               EventLoop::Clock::time_point deadline) {
+    while (!poll_event(event)) {
+        if (input_closed_ || EventLoop::Clock::now() >= deadline) return false;
+        // Одиночный ESC должен выйти по таймауту, даже если ввода больше нет
+        wait_input(std::min(deadline, parser_.flush_deadline()));
+    }
+    return true;
+}
+
+bool ConsoleEngine::wait_input(EventLoop::Clock::time_point deadline) {
+    uint64_t seen = input_count_;
+    // Заодно включает raw-режим, иначе poll() ждал бы целой строки
+    poll_input();
+    if (input_count_ != seen) return true;
+    // Ввод закончился: без наблюдения за stdin run_once мог бы уснуть
+    // навсегда
+    if (input_closed_) return false;
+    // Обработчик ставится только на время ожидания, в остальное время ввод
+    // забирают poll_input() и key_pressed()
+    bool watching = in_fd_ >= 0;
+    if (watching) {
+        loop_->watch(in_fd_, [this] { read_terminal_input(); });
+    }
+    loop_->run_once(deadline);
+    if (watching) loop_->unwatch(in_fd_);
+    return input_count_ != seen;
+}
+
+#ifdef _WIN32
+bool ConsoleEngine::read_terminal_input() {
+    bool any = false;
+    while (::uni_kbhit()) {
+        char c = ::uni_getch();
+        on_input(&c, 1);
+        any = true;
+    }
+    return any;
+}
+#else
+bool ConsoleEngine::read_terminal_input() {
+    if (!raw_session_) raw_session_ = RawModeSession::acquire(in_fd_);
+    char buf[decltype(input_)::capacity()];
+    bool any = false;
+    while (true) {
+        // VMIN/VTIME действуют только на tty: из канала или файла read()
+        // ждал бы данных. Поэтому сначала спрашиваем poll(), есть ли они
+        pollfd ready{in_fd_, POLLIN, 0};
+        if (::poll(&ready, 1, 0) <= 0) return any;
+        ssize_t count = ::read(in_fd_, buf, sizeof(buf));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) {
+            // poll() сообщил о вводе, а прочитать нечего - это конец файла
+            // или ошибка, больше ввода не будет
+            input_closed_ = true;
+            return any;
+        }
+        on_input(buf, count);
+        any = true;
+        if (count < static_cast<ssize_t>(sizeof(buf))) return any;
     }
-    return '\0';
 }
+#endif
 
 void ConsoleEngine::reset_styles() {
-    cout_ << "\033[" << static_cast<int>(ConsoleStyle::Reset) << "m";
+    write_sgr(AnsiTables::param(ConsoleStyle::Reset));
+    encoder_.style_was_reset();
 }
 void ConsoleEngine::set_style(ConsoleStyle style) {
-    cout_ << "\033[" << static_cast<int>(style) << "m";
+    write_sgr(AnsiTables::param(style));
+    encoder_.forget_style();
 }
+// Цвета проходят через кодировщик: терминал на 16 цветов или без цвета
+// не должен получать последовательности 256 цветов
 void ConsoleEngine::set_color(ConsoleTextColors text_color) {
-    cout_ << "\033[" << static_cast<int>(text_color) << "m";
+    write_sgr(encoder_.text_color_param(text_color));
+    encoder_.forget_style();
 }
 void ConsoleEngine::set_color(ConsoleBkgColors background_color) {
-    cout_ << "\033[" << static_cast<int>(background_color) << "m";
+    write_sgr(encoder_.background_color_param(background_color));
+    encoder_.forget_style();
 }
 void ConsoleEngine::set_color(ConsoleTextColors text_color,
                               ConsoleBkgColors background_color) {
-    cout_ << "\033[" << static_cast<int>(text_color) << ";"
-          << static_cast<int>(background_color) << "m";
+    write_sgr(encoder_.text_color_param(text_color),
+              encoder_.background_color_param(background_color));
+    encoder_.forget_style();
 }
 void ConsoleEngine::set_text_color(Color256 color) {
-    cout_ << "\033[38;5;" << static_cast<int>(color.id) << "m";
+    write_sgr(encoder_.text_color_param(color));
+    encoder_.forget_style();
 }
 void ConsoleEngine::set_background_color(Color256 color) {
-    cout_ << "\033[48;5;" << static_cast<int>(color.id) << "m";
+    write_sgr(encoder_.background_color_param(color));
+    encoder_.forget_style();
+}
+
+void ConsoleEngine::write_sgr(std::string_view param) {
+    if (param.empty()) return;
+    write("\033[");
+    write(param);
+    write("m");
+}
+void ConsoleEngine::write_sgr(std::string_view param1,
+                              std::string_view param2) {
+    if (param1.empty() || param2.empty()) {
+        write_sgr(param1.empty() ? param2 : param1);
+        return;
+    }
+    write("\033[");
+    write(param1);
+    write(";");
+    write(param2);
+    write("m");
+}
+
+void ConsoleEngine::begin_frame() { ++frame_depth_; }
+
+void ConsoleEngine::end_frame() {
+    if (frame_depth_ == 0 || --frame_depth_ > 0) return;
+    if (frame_buf_.empty()) return;
+    write_to_output(frame_buf_);
+    frame_buf_.clear();
+}
+
+void ConsoleEngine::write(std::string_view data) {
+    if (frame_depth_ > 0)
+        frame_buf_ += data;
+    else
+        cout_ << data;
+}
+
+void ConsoleEngine::flush() {
+    if (frame_depth_ == 0) cout_.flush();
+}
+
+#ifdef _WIN32
+void ConsoleEngine::write_to_output(std::string_view data) {
+    cout_.write(data.data(), data.size());
+    cout_.flush();
+}
+#else
+namespace {
+void write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data.remove_prefix(written);
+    }
+}
+}  // namespace
+
+void ConsoleEngine::write_to_output(std::string_view data) {
+    if (out_fd_ < 0) {
+        cout_.write(data.data(), data.size());
+        cout_.flush();
+        return;
+    }
+    // Всё, что успели вывести через поток, должно уйти раньше кадра
+    cout_.flush();
+    write_all(out_fd_, data);
+}
+#endif
+
+void ConsoleEngine::start_render_thread() {
+    if (renderer_) return;
+    cout_.flush();
+    std::ostream& out = cout_;
+    RenderThread::Sink sink = [&out](std::string_view data) {
+        out.write(data.data(), data.size());
+        out.flush();
+    };
+#ifndef _WIN32
+    if (out_fd_ >= 0)
+        sink = [fd = out_fd_](std::string_view data) { write_all(fd, data); };
+#endif
+    renderer_ = std::make_unique<RenderThread>(std::move(sink), front_,
+                                               encoder_);
+}
+
+void ConsoleEngine::stop_render_thread() {
+    if (!renderer_) return;
+    renderer_->stop();
+    front_ = renderer_->screen();
+    encoder_ = renderer_->encoder();
+    renderer_.reset();
+}
+
+void ConsoleEngine::set_synchronized_output(bool enabled) {
+    encoder_.set_synchronized(enabled);
+}
+
+void ConsoleEngine::set_color_depth(ColorDepth depth) {
+    encoder_.set_color_depth(depth);
+}
+
+uint64_t ConsoleEngine::dropped_frames() const {
+    return renderer_ ? renderer_->dropped_frames() : 0;
+}
+
+void ConsoleEngine::start_recording(std::ostream& out) {
+    recorder_ = std::make_unique<FrameRecorder>(out);
+}
+
+bool ConsoleEngine::start_recording(const std::string& path) {
+    auto file = std::make_unique<std::ofstream>(path, std::ios::binary);
+    if (!*file) return false;
+    recorder_ = std::make_unique<FrameRecorder>(std::move(file));
+    return true;
+}
+
+void ConsoleEngine::stop_recording() {
+    recorder_.reset();
+    record_path_.clear();
+}
+
+void ConsoleEngine::resize_buffer(int width, int height) {
+    back_.resize(width, height);
+    front_.resize(width, height, FrameBuffer::unknown_cell);
+}
+
+void ConsoleEngine::set_cell(int x, int y, ConsoleCell cell) {
+    if (!back_.contains(x, y)) return;
+    back_.at(x, y) = cell;
+}
+
+const ConsoleCell& ConsoleEngine::get_cell(int x, int y) const {
+    return back_.at(x, y);
+}
+
+void ConsoleEngine::draw_text(int x, int y, std::string_view text,
+                              ConsoleCell style) {
+    back_.draw_text(x, y, text, style);
+}
+
+void ConsoleEngine::blit(int x, int y, const char* glyphs, int width,
+                         int height, ConsoleCell style, char transparent) {
+    back_.blit(x, y, glyphs, width, height, style, transparent);
+}
+
+void ConsoleEngine::blit(int x, int y, const FrameBuffer& block) {
+    back_.paste(block, x, y);
+}
+
+void ConsoleEngine::fill_rect(int x, int y, int width, int height,
+                              ConsoleCell cell) {
+    back_.fill_rect(x, y, width, height, cell);
+}
+
+void ConsoleEngine::draw_rect(int x, int y, int width, int height,
+                              ConsoleCell border) {
+    if (width <= 0 || height <= 0) return;
+    back_.fill_rect(x, y, width, 1, border);
+    back_.fill_rect(x, y + height - 1, width, 1, border);
+    back_.fill_rect(x, y, 1, height, border);
+    back_.fill_rect(x + width - 1, y, 1, height, border);
+}
+
+void ConsoleEngine::scroll_region(int top, int bottom, int lines) {
+    back_.scroll(top, bottom, lines, ConsoleCell());
+    if (renderer_)
+        renderer_->scroll(top, bottom, lines);
+    else
+        encoder_.request_scroll(top, bottom, lines);
+}
+
+SavedRegion ConsoleEngine::save_region(int x, int y, int width,
+                                       int height) const {
+    return {x, y, back_.copy_rect(x, y, width, height)};
 }
+
+void ConsoleEngine::restore_region(const SavedRegion& region) {
+    back_.paste(region.cells, region.x, region.y);
+}
+
+void ConsoleEngine::invalidate() {
+    if (renderer_)
+        renderer_->invalidate();
+    else
+        front_.fill(FrameBuffer::unknown_cell);
+}
+
+void ConsoleEngine::present() {
+    update_terminal_size();
+    // Файл открывается только у движка, который что-то рисует
+    if (!record_path_.empty()) {
+        start_recording(record_path_);
+        record_path_.clear();
+    }
+    if (recorder_) recorder_->record(back_);
+
+    SavedRegion under_overlay;
+    if (stats_overlay_) {
+        under_overlay = save_region(0, back_.height() - 1, back_.width(), 1);
+        draw_stats_overlay();
+    }
+    auto start = FrameStats::Clock::now();
+    if (renderer_) {
+        renderer_->submit(back_);
+        RenderThread::Output output = renderer_->take_output();
+        stats_->end_frame(output.render_time, output.flush_time, output.bytes,
+                          output.cells_changed);
+    } else {
+        std::size_t size_before = frame_buf_.size();
+        begin_frame();
+        budget_.frame_started(start);
+        // Скорость имеет смысл мерить только у настоящего терминала
+        std::size_t budget =
+            out_fd_ >= 0 ? budget_.frame_budget() : OutputBudget::unlimited;
+        int changed =
+            encoder_.encode_frame(frame_buf_, back_, front_, budget);
+        std::size_t bytes = frame_buf_.size() - size_before;
+        auto encoded = FrameStats::Clock::now();
+        end_frame();
+        auto flushed = FrameStats::Clock::now();
+        budget_.wrote(bytes, flushed - encoded);
+        stats_->end_frame(encoded - start, flushed - encoded, bytes, changed);
+    }
+    if (stats_overlay_) restore_region(under_overlay);
+}
+
+void ConsoleEngine::draw_stats_overlay() {
+    if (stats_->size() == 0 || back_.height() == 0) return;
+    const FrameStats::Sample& last = stats_->last();
+    auto value = [&](FrameMetric metric) {
+        return std::to_string(last[static_cast<std::size_t>(metric)]);
+    };
+    std::string text = "upd " + value(FrameMetric::UpdateTime) + "us ren " +
+                       value(FrameMetric::RenderTime) + "us out " +
+                       value(FrameMetric::FlushTime) + "us " +
+                       value(FrameMetric::Bytes) + "B " +
+                       value(FrameMetric::CellsChanged) + " cells ";
+    ConsoleCell style;
+    style.set_style(ConsoleStyle::Inverse);
+    fill_rect(0, back_.height() - 1, back_.width(), 1, style);
+    draw_text(0, back_.height() - 1, text, style);
+}
+
+bool ConsoleEngine::poll_resize() {
+    update_terminal_size();
+    return std::exchange(resized_, false);
+}
+
+void ConsoleEngine::update_terminal_size() {
+    if (out_fd_ < 0 ||
+        !TerminalWindow::size_may_have_changed(resize_generation_))
+        return;
+    TerminalSize size;
+    if (!TerminalWindow::query_size(out_fd_, size) || size == terminal_size_)
+        return;
+    terminal_size_ = size;
+    resized_ = true;
+    if (renderer_)
+        renderer_->set_viewport(size.width, size.height);
+    else
+        encoder_.set_viewport(size.width, size.height, front_);
+}
+
 #ifdef _WIN32
 void ConsoleEngine::flush_input_buffer() {
     HANDLE h = GetStdHandle(STD_INPUT_HANDLE);
@@ -75,14 +525,23 @@ void ConsoleEngine::flush_input_buffer() {
 }
 #endif
 
+void ConsoleEngine::set_key_release_timeout(
+    std::chrono::milliseconds timeout) {
+    key_states_.set_release_timeout(timeout);
+}
+
+void ConsoleEngine::set_key_repeat_delay(std::chrono::milliseconds delay) {
+    key_states_.set_repeat_delay(delay);
+}
+
 #ifdef _WIN32
 bool ConsoleEngine::key_pressed(char key) {
     return GetAsyncKeyState(key) & 0x8000;
 }
 #else
-bool ConsoleEngine::key_pressed(char key){
-    // TODO: сделать поддержку
-    return get_no_wait() == key;
+bool ConsoleEngine::key_pressed(char key) {
+    poll_input();
+    return key_states_.is_down(key, KeyStateTable::Clock::now());
 }
 #endif
 
@@ -1,7 +1,27 @@
 #pragma once
+#include <charconv>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <cstdint>
+#include <memory>
+
+#include "AnsiEncoder.h"
+#include "ConsoleColors.h"
+#include "EventLoop.h"
+#include "FrameBuffer.h"
+#include "FrameRecording.h"
+#include "FrameStats.h"
+#include "InputParser.h"
+#include "KeyStateTable.h"
+#include "OutputBudget.h"
+#include "RawModeSession.h"
+#include "RenderThread.h"
+#include "RingBuffer.h"
+#include "TerminalSize.h"
 
 #ifdef _WIN32
 #define NOMINMAX
@@ -10,107 +30,35 @@
 inline bool uni_kbhit() { return _kbhit() != 0; }
 inline char uni_getch() { return _getch(); }
 #else
-#include <stdio.h>
-#include <sys/select.h>
-#include <termios.h>
 #include <unistd.h>
-
-inline bool uni_kbhit() {
-    int ch = -1;
-    struct termios old_termios, new_termios;
-    tcgetattr(STDIN_FILENO, &old_termios);
-    new_termios = old_termios;
-    new_termios.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &new_termios);
-    fd_set read_fds;
-    FD_ZERO(&read_fds);
-    FD_SET(STDIN_FILENO, &read_fds);
-    struct timeval timeout = {0, 0};  // неблокирующий
-    int ready = select(STDIN_FILENO + 1, &read_fds, nullptr, nullptr, &timeout);
-    if (ready > 0 && FD_ISSET(STDIN_FILENO, &read_fds)) {
-        ch = getchar();
-        ungetc(ch, stdin);  // вернуть символ обратно
-    }
-    tcsetattr(STDIN_FILENO, TCSANOW, &old_termios);
-    return ch != -1;
-}
-
-inline char uni_getch() {
-    struct termios old_termios, new_termios;
-    tcgetattr(STDIN_FILENO, &old_termios);
-    new_termios = old_termios;
-    new_termios.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &new_termios);
-    char ch = getchar();
-    tcsetattr(STDIN_FILENO, TCSANOW, &old_termios);
-    return ch;
-}
 #endif
 
-enum class ConsoleStyle {
-    Reset = 0,
-    Bold = 1,
-    Underline = 4,
-    Inverse = 7,
-};
-enum class ConsoleTextColors {
-    Black = 30,
-    Red = 31,
-    Green = 32,
-    Yellow = 33,
-    Blue = 34,
-    Magenta = 35,
-    Cyan = 36,
-    White = 37,
-};
-enum class ConsoleBkgColors {
-    Black = 40,
-    Red = 41,
-    Green = 42,
-    Yellow = 43,
-    Blue = 44,
-    Magenta = 45,
-    Cyan = 46,
-    White = 47,
-};
-
-struct Color256 {
-    uint8_t id;
-    constexpr Color256(int i) : id(static_cast<uint8_t>(i)) {};
+// Ячейки back-буфера под всплывающим окном, чтобы потом вернуть их на место
+struct SavedRegion {
+    int x = 0;
+    int y = 0;
+    FrameBuffer cells;
 };
 
-namespace Colors256{
-    constexpr Color256 Black{0};
-    constexpr Color256 Red{196};
-    constexpr Color256 Green{46};
-    constexpr Color256 Yellow{226};
-    constexpr Color256 Blue{21};
-    constexpr Color256 Magenta{201};
-    constexpr Color256 Cyan{51};
-    constexpr Color256 White{231};
-    constexpr Color256 Pink{198};
-    constexpr Color256 Orange{208};
-    constexpr Color256 Gray20{235};
-    constexpr Color256 Gray50{240};
-    constexpr Color256 Gray80{248};
-    constexpr Color256 DarkGreen{22};
-    constexpr Color256 GrayBrown{101};
-    constexpr Color256 LightBrown{136};
-    constexpr Color256 OrangeBrown{130};
-    constexpr Color256 Purple{92};
-}
-
 class ConsoleEngine {
   public:
     ConsoleEngine();
     ConsoleEngine(std::istream& in, std::ostream& out);
     ~ConsoleEngine();
+    // Движок владеет потоком вывода и записью кадров; одной игре - один
+    // движок, остальные получают ссылку
+    ConsoleEngine(const ConsoleEngine&) = delete;
+    ConsoleEngine& operator=(const ConsoleEngine&) = delete;
     void clear();
     void set_cursor_to_zero();
     void set_cursor_to_pos(int x, int y);
     template <typename... Args>
     void print(Args... args) {
-        ((cout_ << args), ...);
+        if (frame_depth_ > 0)
+            (append_to_frame(args), ...);
+        else
+            ((cout_ << args), ...);
+        encoder_.forget_cursor();
     };
     template <typename... Args>
     void print_color(ConsoleTextColors text_color,
@@ -154,13 +102,186 @@ class ConsoleEngine {
     void set_background_color(Color256 color);
     std::string get();
     char get_no_wait();
+    // Все нажатые с прошлого вызова клавиши за один проход. Строка живет до
+    // следующего вызова
+    std::string_view drain_keys();
+    // Не забирает клавишу из ввода, можно опрашивать несколько клавиш подряд
     bool key_pressed(char key);
+    // Следующее событие клавиатуры: стрелки, ESC, Enter и т.д. уже
+    // разобраны из escape-последовательностей. Очередь общая с drain_keys,
+    // но читать их независимо друг от друга
+    bool poll_event(KeyEvent& event);
+    // То же, но ждет события до deadline. Поток при этом спит в poll() -
+    // в меню и подсказках процессор не крутится вхолостую. Когда ввод
+    // закончился (input_closed), сразу возвращает false
+    bool wait_event(KeyEvent& event, EventLoop::Clock::time_point deadline =
+                                         EventLoop::Clock::time_point::max());
+    // Спит до deadline, прихода ввода, таймера из event_loop() или его
+    // wake(). true, если пришли новые байты. После конца ввода не ждет
+    bool wait_input(EventLoop::Clock::time_point deadline);
+    // stdin закрыт (конец файла или канала) - нажатий больше не будет
+    bool input_closed() const { return input_closed_; }
+    // Через него можно завести таймеры или разбудить ожидание из другого
+    // потока
+    EventLoop& event_loop() { return *loop_; }
+    void set_key_release_timeout(std::chrono::milliseconds timeout);
+    void set_key_repeat_delay(std::chrono::milliseconds delay);
     void hide_cursor();
     void show_cursor();
+
+    // Отложенная отрисовка: рисуем в back-буфер, present() отправляет
+    // в терминал только изменившиеся ячейки
+    void resize_buffer(int width, int height);
+    int buffer_width() const { return back_.width(); }
+    int buffer_height() const { return back_.height(); }
+    void set_cell(int x, int y, ConsoleCell cell);
+    const ConsoleCell& get_cell(int x, int y) const;
+    void draw_text(int x, int y, std::string_view text,
+                   ConsoleCell style = ConsoleCell());
+    void fill_rect(int x, int y, int width, int height, ConsoleCell cell);
+    // Спрайт или любой блок символов, см. FrameBuffer::blit
+    void blit(int x, int y, const char* glyphs, int width, int height,
+              ConsoleCell style = ConsoleCell(), char transparent = '\0');
+    template <std::size_t Width, std::size_t Height>
+    void blit(int x, int y,
+              const std::array<std::array<char, Width>, Height>& sprite,
+              ConsoleCell style = ConsoleCell(), char transparent = '\0') {
+        back_.blit(x, y, sprite, style, transparent);
+    }
+    // Готовый блок ячеек, например собранная игрой сцена
+    void blit(int x, int y, const FrameBuffer& block);
+    // Только рамка, внутренность не трогается
+    void draw_rect(int x, int y, int width, int height, ConsoleCell border);
+    // Сдвигает строки [top, bottom) back-буфера на lines вверх (lines < 0 -
+    // вниз), открывшиеся строки пустые. present() при этом прокрутит
+    // область в самом терминале (DECSTBM + SU/SD), если так дешевле, и
+    // выведет только новые строки и то, что сдвинулось иначе, чем фон
+    void scroll_region(int top, int bottom, int lines);
+    SavedRegion save_region(int x, int y, int width, int height) const;
+    void restore_region(const SavedRegion& region);
+    void present();
+    void invalidate();
+
+    // Размер окна терминала; 0, если вывод идет не в терминал.
+    // Ячейки буфера за пределами окна не выводятся
+    int terminal_width() const { return terminal_size_.width; }
+    int terminal_height() const { return terminal_size_.height; }
+    // true, если окно изменило размер с прошлого вызова. Перерисовывать
+    // ничего не нужно - present() сам выведет открывшиеся области
+    bool poll_resize();
+
+    // present() только отдает кадр потоку вывода и сразу возвращается.
+    // Пока поток работает, print, set_color и перемещение курсора
+    // использовать нельзя - весь вывод идет через буфер
+    void start_render_thread();
+    void stop_render_thread();
+    uint64_t dropped_frames() const;
+
+    // Каждый present() дописывает кадр в запись. Если задана переменная
+    // CONSOLE_ENGINE_RECORD, движок по умолчанию пишет в этот файл сам;
+    // stop_recording() отменяет и это
+    void start_recording(std::ostream& out);
+    bool start_recording(const std::string& path);
+    void stop_recording();
+
+    // Замеры каждого present(). CONSOLE_ENGINE_STATS=file сохраняет их при
+    // выходе, CONSOLE_ENGINE_STATS_OVERLAY=1 показывает в нижней строке.
+    // С потоком вывода время, байты и ячейки берутся из самого потока и
+    // попадают в замер следующего present()
+    FrameStats& stats() { return *stats_; }
+    void set_stats_overlay(bool enabled) { stats_overlay_ = enabled; }
+
+    // Кадры present() уходят в режиме синхронного вывода, и терминал
+    // рисует каждый один раз, без полуготовых состояний. Включен по
+    // умолчанию, если вывод идет в терминал; CONSOLE_ENGINE_SYNC=0
+    // выключает. Менять до start_render_thread()
+    void set_synchronized_output(bool enabled);
+    // Сколько цветов понимает терминал; по умолчанию 256, если TERM не
+    // говорит о слабом терминале. Если канал не успевает, кадры сами уходят
+    // беднее, чтобы уложиться во время кадра. Цвета set_text_color,
+    // print_color и т.п. тоже выводятся с этой глубиной. Менять до
+    // start_render_thread()
+    void set_color_depth(ColorDepth depth);
+
+    // Внутри кадра весь вывод копится в буфере и уходит в терминал одной
+    // записью в end_frame(). Кадры могут быть вложенными
+    void begin_frame();
+    void end_frame();
+
   private:
     std::istream& cin_;
     std::ostream& cout_;
+    int out_fd_ = -1;
+    int in_fd_ = -1;
+    std::shared_ptr<RawModeSession> raw_session_;
+    RingBuffer<char, 256> input_;
+    InputParser parser_;
+    RingBuffer<KeyEvent, 64> events_;
+    // Сколько байт ввода прочитано всего - по нему видно, пришло ли новое
+    uint64_t input_count_ = 0;
+    bool input_closed_ = false;
+    std::unique_ptr<EventLoop> loop_ = std::make_unique<EventLoop>();
+    KeyStateTable key_states_;
+    std::string keys_buf_;
+    int frame_depth_ = 0;
+    std::string frame_buf_;
+    FrameBuffer back_;
+    FrameBuffer front_;
+    AnsiEncoder encoder_;
+    OutputBudget budget_;
+    std::unique_ptr<RenderThread> renderer_;
+    std::unique_ptr<FrameRecorder> recorder_;
+    std::string record_path_;
+    // Сохраняется в файл вместе с движком
+    std::unique_ptr<FrameStats> stats_ = std::make_unique<FrameStats>();
+    bool stats_overlay_ = false;
+    TerminalSize terminal_size_;
+    unsigned resize_generation_ = 0;
+    bool resized_ = false;
+
+    void poll_input();
+    void update_terminal_size();
+    void draw_stats_overlay();
+    bool read_terminal_input();
+    void on_input(const char* data, std::size_t count);
+    void on_event(const KeyEvent& event);
+    void write(std::string_view data);
+    void write_sgr(std::string_view param);
+    void write_sgr(std::string_view param1, std::string_view param2);
+    void flush();
+    void write_to_output(std::string_view data);
+    template <typename T>
+    void append_to_frame(const T& value) {
+        if constexpr (std::is_same_v<T, char>) {
+            frame_buf_ += value;
+        } else if constexpr (std::is_convertible_v<const T&,
+                                                   std::string_view>) {
+            frame_buf_ += std::string_view(value);
+        } else if constexpr (std::is_arithmetic_v<T> &&
+                             !std::is_same_v<T, bool>) {
+            char buf[64];
+            auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            frame_buf_.append(buf, result.ptr);
+        } else {
+            std::ostringstream ss;
+            ss << value;
+            frame_buf_ += ss.str();
+        }
+    }
 
     void flush_input_buffer();
     void enableAnsiColors();
-};
\ No newline at end of file
+};
+
+class ConsoleFrame {
+  public:
+    explicit ConsoleFrame(ConsoleEngine& engine) : engine(engine) {
+        engine.begin_frame();
+    }
+    ~ConsoleFrame() { engine.end_frame(); }
+    ConsoleFrame(const ConsoleFrame&) = delete;
+    ConsoleFrame& operator=(const ConsoleFrame&) = delete;
+
+  private:
+    ConsoleEngine& engine;
+};
@@ -0,0 +1,186 @@
+#include "EventLoop.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <conio.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace {
+// Таймауты округляются вверх, иначе за миллисекунду до дедлайна poll()
+// будет возвращаться сразу и цикл начнет крутиться вхолостую
+int timeout_ms(EventLoop::Clock::time_point deadline) {
+    if (deadline == EventLoop::Clock::time_point::max()) return -1;
+    auto left = deadline - EventLoop::Clock::now();
+    if (left <= EventLoop::Clock::duration::zero()) return 0;
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+    return static_cast<int>(std::min<long long>(ms, 24 * 60 * 60 * 1000));
+}
+}  // namespace
+
+void EventLoop::watch(int fd, Callback on_readable) {
+    unwatch(fd);
+    watches_.push_back({fd, std::move(on_readable)});
+}
+
+void EventLoop::unwatch(int fd) {
+    std::erase_if(watches_, [fd](const Watch& w) { return w.fd == fd; });
+}
+
+EventLoop::TimerId EventLoop::add_timer(Clock::duration delay,
+                                        Callback callback,
+                                        Clock::duration repeat) {
+    TimerId id = next_timer_id_++;
+    timers_.push_back({id, Clock::now() + delay, repeat, std::move(callback)});
+    return id;
+}
+
+void EventLoop::cancel_timer(TimerId id) {
+    std::erase_if(timers_, [id](const Timer& t) { return t.id == id; });
+}
+
+EventLoop::Clock::time_point EventLoop::next_due() const {
+    auto due = Clock::time_point::max();
+    for (const Timer& timer : timers_) due = std::min(due, timer.due);
+    return due;
+}
+
+bool EventLoop::run_timers() {
+    auto now = Clock::now();
+    // Обработчик может добавить или снять таймер, поэтому сначала
+    // собираем сработавшие
+    std::vector<Timer> due;
+    for (auto it = timers_.begin(); it != timers_.end();) {
+        if (it->due > now) {
+            ++it;
+            continue;
+        }
+        due.push_back(*it);
+        if (it->repeat > Clock::duration::zero()) {
+            // Пропущенные срабатывания не догоняются
+            while (it->due <= now) it->due += it->repeat;
+            ++it;
+        } else {
+            it = timers_.erase(it);
+        }
+    }
+    // Если поток опоздал, срабатывают сразу несколько - по порядку сроков,
+    // а не добавления
+    std::sort(due.begin(), due.end(), [](const Timer& a, const Timer& b) {
+        return a.due != b.due ? a.due < b.due : a.id < b.id;
+    });
+    for (const Timer& timer : due) timer.callback();
+    return !due.empty();
+}
+
+bool EventLoop::run_once(Clock::time_point deadline) {
+    if (run_timers()) return true;
+    if (wait(std::min(deadline, next_due()))) return true;
+    return run_timers();
+}
+
+void EventLoop::run() {
+    running_ = true;
+    while (running_) run_once();
+}
+
+void EventLoop::stop() {
+    running_ = false;
+    wake();
+}
+
+#ifdef _WIN32
+EventLoop::EventLoop() {
+    wake_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+}
+
+EventLoop::~EventLoop() {
+    if (wake_event_) CloseHandle(wake_event_);
+}
+
+void EventLoop::wake() {
+    if (wake_event_) SetEvent(wake_event_);
+}
+
+bool EventLoop::wait(Clock::time_point deadline) {
+    HANDLE handles[2] = {wake_event_, nullptr};
+    DWORD count = 1;
+    Callback on_input;
+    for (const Watch& w : watches_) {
+        if (w.fd != 0) continue;
+        handles[count++] = GetStdHandle(STD_INPUT_HANDLE);
+        on_input = w.callback;
+    }
+    int timeout = timeout_ms(deadline);
+    DWORD result = WaitForMultipleObjects(
+        count, handles, FALSE, timeout < 0 ? INFINITE : DWORD(timeout));
+    if (result == WAIT_OBJECT_0) return true;
+    if (result != WAIT_OBJECT_0 + 1) return false;
+    // Хэндл консоли срабатывает и на события мыши и фокуса, а их _getch
+    // не вернет. Такие события просто выбрасываем
+    if (!_kbhit()) {
+        FlushConsoleInputBuffer(handles[1]);
+        return false;
+    }
+    if (on_input) on_input();
+    return true;
+}
+#else
+EventLoop::EventLoop() {
+    if (pipe(wake_pipe_) != 0) return;
+    for (int fd : wake_pipe_) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : wake_pipe_) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void EventLoop::wake() {
+    if (wake_pipe_[1] < 0) return;
+    char byte = 1;
+    // Если канал полон, run_once и так проснется
+    while (::write(wake_pipe_[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+}
+
+bool EventLoop::wait(Clock::time_point deadline) {
+    std::vector<pollfd> fds;
+    fds.reserve(watches_.size() + 1);
+    fds.push_back({wake_pipe_[0], POLLIN, 0});
+    for (const Watch& w : watches_) fds.push_back({w.fd, POLLIN, 0});
+
+    int ready = ::poll(fds.data(), fds.size(), timeout_ms(deadline));
+    // EINTR - пришел сигнал; вызывающий сам проверит, что изменилось
+    if (ready < 0) return errno == EINTR;
+    if (ready == 0) return false;
+
+    if (fds[0].revents & POLLIN) {
+        char buf[64];
+        while (::read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+        }
+    }
+    // Обработчик может снять наблюдение, поэтому копируем готовые
+    std::vector<Callback> readable;
+    for (std::size_t i = 1; i < fds.size(); ++i) {
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            readable.push_back(watches_[i - 1].callback);
+    }
+    for (const Callback& callback : readable) {
+        if (callback) callback();
+    }
+    return true;
+}
+#endif
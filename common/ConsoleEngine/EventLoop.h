@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Ждет сразу нескольких вещей: готовности файловых дескрипторов (stdin),
+// таймеров и wake() из других потоков. Пока ждать нечего, поток спит в
+// poll() и не тратит процессор
+class EventLoop {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using TimerId = uint64_t;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // on_readable вызывается из run_once, когда из fd можно читать.
+    // В Windows поддерживается только консольный ввод (fd 0)
+    void watch(int fd, Callback on_readable);
+    void unwatch(int fd);
+    // Срабатывает через delay; если repeat не ноль - повторяется
+    TimerId add_timer(Clock::duration delay, Callback callback,
+                      Clock::duration repeat = Clock::duration::zero());
+    void cancel_timer(TimerId id);
+
+    // Будит run_once. Можно вызывать из любого потока
+    void wake();
+
+    // Ждет до deadline, пока не произойдет хотя бы одно событие, и
+    // вызывает их обработчики. false, если просто истекло время.
+    // Сигнал (например, SIGWINCH) тоже прерывает ожидание
+    bool run_once(Clock::time_point deadline = Clock::time_point::max());
+    // Крутит run_once, пока не вызван stop()
+    void run();
+    void stop();
+
+  private:
+    struct Watch {
+        int fd;
+        Callback callback;
+    };
+    struct Timer {
+        TimerId id;
+        Clock::time_point due;
+        Clock::duration repeat;
+        Callback callback;
+    };
+
+    std::vector<Watch> watches_;
+    std::vector<Timer> timers_;
+    TimerId next_timer_id_ = 1;
+    bool running_ = false;
+#ifdef _WIN32
+    void* wake_event_ = nullptr;
+#else
+    // Self-pipe: wake() пишет байт, poll() видит его как ввод
+    int wake_pipe_[2] = {-1, -1};
+#endif
+
+    Clock::time_point next_due() const;
+    bool run_timers();
+    bool wait(Clock::time_point deadline);
+};
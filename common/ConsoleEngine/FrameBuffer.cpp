@@ -0,0 +1,140 @@
+#include "FrameBuffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+void ConsoleCell::set_style(ConsoleStyle style) {
+    switch (style) {
+        case ConsoleStyle::Reset:
+            *this = ConsoleCell(glyph);
+            break;
+        case ConsoleStyle::Bold:
+            attrs |= CellAttrs::Bold;
+            break;
+        case ConsoleStyle::Underline:
+            attrs |= CellAttrs::Underline;
+            break;
+        case ConsoleStyle::Inverse:
+            attrs |= CellAttrs::Inverse;
+            break;
+    }
+}
+void ConsoleCell::set_text_color(Color256 color) {
+    fg = color;
+    attrs |= CellAttrs::TextColor;
+}
+void ConsoleCell::set_background_color(Color256 color) {
+    bg = color;
+    attrs |= CellAttrs::BkgColor;
+}
+
+FrameBuffer::FrameBuffer(int width, int height, ConsoleCell fill) {
+    resize(width, height, fill);
+}
+
+void FrameBuffer::resize(int width, int height, ConsoleCell fill) {
+    width = std::max(width, 0);
+    height = std::max(height, 0);
+    std::vector<ConsoleCell> cells(width * height, fill);
+    for (int y = 0; y < std::min(height, height_); ++y) {
+        for (int x = 0; x < std::min(width, width_); ++x) {
+            cells[y * width + x] = at(x, y);
+        }
+    }
+    cells_ = std::move(cells);
+    width_ = width;
+    height_ = height;
+}
+
+void FrameBuffer::fill(ConsoleCell cell) {
+    std::fill(cells_.begin(), cells_.end(), cell);
+}
+
+FrameBuffer::Clip FrameBuffer::clip(int x, int y, int width,
+                                    int height) const {
+    Clip clip;
+    clip.src_x = std::max(0, -x);
+    clip.src_y = std::max(0, -y);
+    clip.x = x + clip.src_x;
+    clip.y = y + clip.src_y;
+    clip.width = std::min(width, width_ - x) - clip.src_x;
+    clip.height = std::min(height, height_ - y) - clip.src_y;
+    return clip;
+}
+
+void FrameBuffer::fill_rect(int x, int y, int width, int height,
+                            ConsoleCell cell) {
+    Clip area = clip(x, y, width, height);
+    if (area.empty()) return;
+    for (int row = 0; row < area.height; ++row) {
+        ConsoleCell* dst = &at(area.x, area.y + row);
+        std::fill(dst, dst + area.width, cell);
+    }
+}
+
+FrameBuffer FrameBuffer::copy_rect(int x, int y, int width,
+                                   int height) const {
+    FrameBuffer rect(width, height);
+    Clip area = clip(x, y, rect.width(), rect.height());
+    if (area.empty()) return rect;
+    for (int row = 0; row < area.height; ++row) {
+        const ConsoleCell* src = &at(area.x, area.y + row);
+        std::copy(src, src + area.width,
+                  &rect.at(area.src_x, area.src_y + row));
+    }
+    return rect;
+}
+
+void FrameBuffer::paste(const FrameBuffer& source, int x, int y) {
+    Clip area = clip(x, y, source.width(), source.height());
+    if (area.empty()) return;
+    for (int row = 0; row < area.height; ++row) {
+        const ConsoleCell* src = &source.at(area.src_x, area.src_y + row);
+        std::copy(src, src + area.width, &at(area.x, area.y + row));
+    }
+}
+
+void FrameBuffer::draw_text(int x, int y, std::string_view text,
+                            ConsoleCell style) {
+    Clip area = clip(x, y, int(text.size()), 1);
+    if (area.empty()) return;
+    ConsoleCell* dst = &at(area.x, area.y);
+    for (int i = 0; i < area.width; ++i) {
+        style.glyph = text[area.src_x + i];
+        dst[i] = style;
+    }
+}
+
+void FrameBuffer::blit(int x, int y, const char* glyphs, int width,
+                       int height, ConsoleCell style, char transparent) {
+    Clip area = clip(x, y, width, height);
+    if (area.empty()) return;
+    for (int row = 0; row < area.height; ++row) {
+        const char* src = glyphs + (area.src_y + row) * width + area.src_x;
+        ConsoleCell* dst = &at(area.x, area.y + row);
+        for (int i = 0; i < area.width; ++i) {
+            if (src[i] == transparent) continue;
+            style.glyph = src[i];
+            dst[i] = style;
+        }
+    }
+}
+
+void FrameBuffer::scroll(int top, int bottom, int lines, ConsoleCell fill) {
+    top = std::max(top, 0);
+    bottom = std::min(bottom, height_);
+    if (top >= bottom || lines == 0) return;
+    auto row = [&](int y) { return cells_.begin() + y * width_; };
+    int shift = std::min(std::abs(lines), bottom - top);
+    if (lines > 0) {
+        std::copy(row(top + shift), row(bottom), row(top));
+        std::fill(row(bottom - shift), row(bottom), fill);
+    } else {
+        std::copy_backward(row(top), row(bottom - shift), row(bottom));
+        std::fill(row(top), row(top + shift), fill);
+    }
+}
+
+bool FrameBuffer::contains(int x, int y) const {
+    return x >= 0 && y >= 0 && x < width_ && y < height_;
+}
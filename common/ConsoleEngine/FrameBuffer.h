@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ConsoleColors.h"
+
+namespace CellAttrs {
+constexpr uint8_t None = 0;
+constexpr uint8_t TextColor = 1 << 0;
+constexpr uint8_t BkgColor = 1 << 1;
+constexpr uint8_t Bold = 1 << 2;
+constexpr uint8_t Underline = 1 << 3;
+constexpr uint8_t Inverse = 1 << 4;
+}  // namespace CellAttrs
+
+// Одна ячейка экрана: символ и его оформление
+struct ConsoleCell {
+    char glyph = ' ';
+    Color256 fg{0};
+    Color256 bg{0};
+    uint8_t attrs = CellAttrs::None;
+
+    constexpr ConsoleCell() = default;
+    constexpr ConsoleCell(char glyph) : glyph(glyph) {}
+    constexpr ConsoleCell(char glyph, Color256 fg)
+        : glyph(glyph), fg(fg), attrs(CellAttrs::TextColor) {}
+    constexpr ConsoleCell(char glyph, Color256 fg, Color256 bg)
+        : glyph(glyph),
+          fg(fg),
+          bg(bg),
+          attrs(CellAttrs::TextColor | CellAttrs::BkgColor) {}
+
+    void set_style(ConsoleStyle style);
+    void set_text_color(Color256 color);
+    void set_background_color(Color256 color);
+    bool operator==(const ConsoleCell& other) const = default;
+};
+
+class FrameBuffer {
+  public:
+    // Содержимое ячейки терминала неизвестно и будет перерисовано
+    static constexpr ConsoleCell unknown_cell{'\0'};
+
+    FrameBuffer() = default;
+    FrameBuffer(int width, int height, ConsoleCell fill = ConsoleCell());
+
+    void resize(int width, int height, ConsoleCell fill = ConsoleCell());
+    void fill(ConsoleCell cell);
+    // Прямоугольные операции обрезаются по границам буфера один раз и
+    // дальше копируют строки целиком
+    void fill_rect(int x, int y, int width, int height, ConsoleCell cell);
+    FrameBuffer copy_rect(int x, int y, int width, int height) const;
+    void paste(const FrameBuffer& source, int x, int y);
+    void draw_text(int x, int y, std::string_view text,
+                   ConsoleCell style = ConsoleCell());
+    // Блок символов width x height, строки подряд. Все символы получают
+    // оформление style, символы transparent не рисуются
+    void blit(int x, int y, const char* glyphs, int width, int height,
+              ConsoleCell style = ConsoleCell(), char transparent = '\0');
+    template <std::size_t Width, std::size_t Height>
+    void blit(int x, int y,
+              const std::array<std::array<char, Width>, Height>& sprite,
+              ConsoleCell style = ConsoleCell(), char transparent = '\0') {
+        static_assert(sizeof(sprite) == Width * Height);
+        blit(x, y, sprite[0].data(), int(Width), int(Height), style,
+             transparent);
+    }
+    // Сдвигает строки [top, bottom) на lines вверх (lines < 0 - вниз), как
+    // это делает терминал. Открывшиеся строки заполняются fill
+    void scroll(int top, int bottom, int lines, ConsoleCell fill);
+    bool contains(int x, int y) const;
+    ConsoleCell& at(int x, int y) { return cells_[y * width_ + x]; }
+    const ConsoleCell& at(int x, int y) const {
+        return cells_[y * width_ + x];
+    }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+  private:
+    // Видимая часть прямоугольника: откуда брать в источнике и куда класть
+    struct Clip {
+        int src_x = 0;
+        int src_y = 0;
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+
+        bool empty() const { return width <= 0 || height <= 0; }
+    };
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<ConsoleCell> cells_;
+
+    Clip clip(int x, int y, int width, int height) const;
+};
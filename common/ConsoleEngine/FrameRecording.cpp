@@ -0,0 +1,148 @@
+#include "FrameRecording.h"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void put_cell(std::string& out, const ConsoleCell& cell) {
+    out += cell.glyph;
+    out += static_cast<char>(cell.attrs);
+    if (cell.attrs & CellAttrs::TextColor) out += static_cast<char>(cell.fg.id);
+    if (cell.attrs & CellAttrs::BkgColor) out += static_cast<char>(cell.bg.id);
+}
+}  // namespace
+
+FrameRecorder::FrameRecorder(std::ostream& out) : out_(out) {
+    out_.write(FrameRecording::magic, sizeof(FrameRecording::magic));
+    out_.put(static_cast<char>(FrameRecording::version));
+}
+
+FrameRecorder::FrameRecorder(std::unique_ptr<std::ostream> out)
+    : FrameRecorder(*out) {
+    owned_ = std::move(out);
+}
+
+void FrameRecorder::record(const FrameBuffer& frame, Clock::time_point time) {
+    using std::chrono::milliseconds;
+    milliseconds delay(0);
+    if (started_ && time > last_time_)
+        delay = std::chrono::duration_cast<milliseconds>(time - last_time_);
+    started_ = true;
+    last_time_ = time;
+
+    // Новый размер - кадр пишется целиком
+    if (previous_.width() != frame.width() ||
+        previous_.height() != frame.height())
+        previous_ = FrameBuffer(frame.width(), frame.height(),
+                                FrameBuffer::unknown_cell);
+
+    // Сначала собираем отрезки, их число пишется перед ними
+    runs_.clear();
+    uint64_t run_count = 0;
+    int cells = frame.width() * frame.height();
+    int last_end = 0;
+    for (int i = 0; i < cells;) {
+        int x = i % frame.width(), y = i / frame.width();
+        if (frame.at(x, y) == previous_.at(x, y)) {
+            ++i;
+            continue;
+        }
+        int start = i;
+        for (; i < cells; ++i) {
+            x = i % frame.width();
+            y = i / frame.width();
+            if (frame.at(x, y) == previous_.at(x, y)) break;
+            previous_.at(x, y) = frame.at(x, y);
+        }
+        put_varint(runs_, start - last_end);
+        put_varint(runs_, i - start);
+        for (int j = start; j < i; ++j)
+            put_cell(runs_, frame.at(j % frame.width(), j / frame.width()));
+        last_end = i;
+        ++run_count;
+    }
+
+    buf_.clear();
+    put_varint(buf_, delay.count());
+    put_varint(buf_, frame.width());
+    put_varint(buf_, frame.height());
+    put_varint(buf_, run_count);
+    buf_ += runs_;
+    out_.write(buf_.data(), buf_.size());
+    out_.flush();
+}
+
+FramePlayer::FramePlayer(std::istream& in) : in_(in) {
+    char header[sizeof(FrameRecording::magic) + 1]{};
+    in_.read(header, sizeof(header));
+    if (!in_ ||
+        std::string_view(header, sizeof(FrameRecording::magic)) !=
+            std::string_view(FrameRecording::magic,
+                             sizeof(FrameRecording::magic)))
+        throw std::runtime_error("Not a frame recording");
+    if (static_cast<uint8_t>(header[sizeof(FrameRecording::magic)]) !=
+        FrameRecording::version)
+        throw std::runtime_error("Unsupported frame recording version");
+}
+
+bool FramePlayer::read_varint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in_.get();
+        if (byte == std::istream::traits_type::eof()) return false;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool FramePlayer::read_cell(ConsoleCell& cell) {
+    char data[2];
+    if (!in_.read(data, 2)) return false;
+    cell = ConsoleCell(data[0]);
+    cell.attrs = static_cast<uint8_t>(data[1]);
+    if (cell.attrs & CellAttrs::TextColor) {
+        int id = in_.get();
+        if (id == std::istream::traits_type::eof()) return false;
+        cell.fg = Color256(static_cast<uint8_t>(id));
+    }
+    if (cell.attrs & CellAttrs::BkgColor) {
+        int id = in_.get();
+        if (id == std::istream::traits_type::eof()) return false;
+        cell.bg = Color256(static_cast<uint8_t>(id));
+    }
+    return true;
+}
+
+bool FramePlayer::next() {
+    uint64_t delay, width, height, run_count;
+    if (!read_varint(delay) || !read_varint(width) || !read_varint(height) ||
+        !read_varint(run_count))
+        return false;
+    delay_ = std::chrono::milliseconds(delay);
+    if (width > FrameRecording::max_side || height > FrameRecording::max_side)
+        throw std::runtime_error("Frame size out of range");
+    if (frame_.width() != int(width) || frame_.height() != int(height))
+        frame_ = FrameBuffer(int(width), int(height));
+
+    uint64_t cells = width * height;
+    uint64_t pos = 0;
+    for (uint64_t run = 0; run < run_count; ++run) {
+        uint64_t skip, length;
+        if (!read_varint(skip) || !read_varint(length)) return false;
+        pos += skip;
+        if (pos + length > cells) return false;
+        for (uint64_t end = pos + length; pos < end; ++pos) {
+            if (!read_cell(frame_.at(pos % width, pos / width))) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "FrameBuffer.h"
+
+// Двоичная запись показанных кадров для последующего разбора.
+// Файл начинается с "CEREC" и номера версии, дальше идут кадры:
+//   пауза с прошлого кадра в мс, ширина, высота, число отрезков
+//   и сами отрезки: сколько ячеек пропустить, сколько записано, ячейки.
+// Ячейка - символ, атрибуты и только заданные цвета. Все числа - varint,
+// поэтому кадр без изменений занимает несколько байт
+namespace FrameRecording {
+inline constexpr char magic[] = {'C', 'E', 'R', 'E', 'C'};
+inline constexpr uint8_t version = 1;
+// Больше не бывает ни у какого терминала; защищает от испорченных файлов
+inline constexpr uint64_t max_side = 4096;
+}  // namespace FrameRecording
+
+class FrameRecorder {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameRecorder(std::ostream& out);
+    explicit FrameRecorder(std::unique_ptr<std::ostream> out);
+
+    // Кадр сразу сбрасывается в файл: игру обычно закрывают Ctrl+C, и
+    // буферизованный хвост записи иначе пропал бы
+    void record(const FrameBuffer& frame, Clock::time_point time = Clock::now());
+
+  private:
+    std::unique_ptr<std::ostream> owned_;
+    std::ostream& out_;
+    FrameBuffer previous_;
+    Clock::time_point last_time_{};
+    bool started_ = false;
+    std::string buf_;
+    std::string runs_;
+};
+
+class FramePlayer {
+  public:
+    // Бросает std::runtime_error, если это не запись кадров
+    explicit FramePlayer(std::istream& in);
+
+    // false в конце записи или если она обрезана. Бросает
+    // std::runtime_error, если размер кадра невозможный
+    bool next();
+    const FrameBuffer& frame() const { return frame_; }
+    std::chrono::milliseconds delay() const { return delay_; }
+
+  private:
+    std::istream& in_;
+    FrameBuffer frame_;
+    std::chrono::milliseconds delay_{0};
+
+    bool read_varint(uint64_t& value);
+    bool read_cell(ConsoleCell& cell);
+};
@@ -0,0 +1,109 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace {
+constexpr std::array<std::string_view, FrameStats::metric_count> names = {
+    "update_us", "render_us", "flush_us", "bytes", "cells", "keys"};
+
+std::size_t index(FrameMetric metric) {
+    return static_cast<std::size_t>(metric);
+}
+}  // namespace
+
+FrameStats::~FrameStats() {
+    if (dump_path_.empty() || samples_.empty()) return;
+    std::ofstream file(dump_path_);
+    if (!file) return;
+    std::string_view path = dump_path_;
+    if (path.size() >= 5 && path.substr(path.size() - 5) == ".json")
+        write_json(file);
+    else
+        write_csv(file);
+}
+
+uint64_t FrameStats::to_us(Clock::duration time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+std::string_view FrameStats::name(FrameMetric metric) {
+    return names[index(metric)];
+}
+
+void FrameStats::add_update_time(Clock::duration time) {
+    current_[index(FrameMetric::UpdateTime)] += to_us(time);
+}
+
+void FrameStats::add_keys(uint64_t count) {
+    current_[index(FrameMetric::Keys)] += count;
+}
+
+void FrameStats::end_frame(Clock::duration render_time,
+                           Clock::duration flush_time, uint64_t bytes,
+                           uint64_t cells_changed) {
+    current_[index(FrameMetric::RenderTime)] = to_us(render_time);
+    current_[index(FrameMetric::FlushTime)] = to_us(flush_time);
+    current_[index(FrameMetric::Bytes)] = bytes;
+    current_[index(FrameMetric::CellsChanged)] = cells_changed;
+    if (samples_.full()) samples_.pop();
+    samples_.push(current_);
+    current_ = {};
+}
+
+FrameStats::Summary FrameStats::summary(FrameMetric metric) const {
+    Summary result;
+    if (samples_.empty()) return result;
+    std::vector<uint64_t> values(samples_.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = samples_.peek(i)[index(metric)];
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](int p) {
+        return values[(values.size() - 1) * p / 100];
+    };
+    result.p50 = percentile(50);
+    result.p90 = percentile(90);
+    result.p99 = percentile(99);
+    result.max = values.back();
+    return result;
+}
+
+void FrameStats::write_csv(std::ostream& out) const {
+    out << "frame";
+    for (auto name : names) out << ',' << name;
+    out << '\n';
+    for (std::size_t i = 0; i < samples_.size(); ++i) {
+        out << i;
+        for (uint64_t value : samples_.peek(i)) out << ',' << value;
+        out << '\n';
+    }
+}
+
+void FrameStats::write_json(std::ostream& out) const {
+    out << "{\"summary\":{";
+    for (std::size_t m = 0; m < metric_count; ++m) {
+        Summary s = summary(static_cast<FrameMetric>(m));
+        if (m > 0) out << ',';
+        out << '"' << names[m] << "\":{\"p50\":" << s.p50
+            << ",\"p90\":" << s.p90 << ",\"p99\":" << s.p99
+            << ",\"max\":" << s.max << '}';
+    }
+    out << "},\"frames\":[";
+    for (std::size_t i = 0; i < samples_.size(); ++i) {
+        if (i > 0) out << ',';
+        out << '[';
+        const Sample& sample = samples_.peek(i);
+        for (std::size_t m = 0; m < metric_count; ++m) {
+            if (m > 0) out << ',';
+            out << sample[m];
+        }
+        out << ']';
+    }
+    out << "],\"columns\":[";
+    for (std::size_t m = 0; m < metric_count; ++m) {
+        if (m > 0) out << ',';
+        out << '"' << names[m] << '"';
+    }
+    out << "]}\n";
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "RingBuffer.h"
+
+enum class FrameMetric : uint8_t {
+    UpdateTime,  // мкс в update() игры с прошлого кадра
+    RenderTime,  // мкс на сравнение буферов и кодирование
+    FlushTime,   // мкс на запись в терминал
+    Bytes,
+    CellsChanged,
+    Keys,
+};
+
+// Счетчики последних кадров. Хранятся в кольцевом буфере фиксированного
+// размера, так что замер кадра ничего не выделяет
+class FrameStats {
+  public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t metric_count = 6;
+    static constexpr std::size_t capacity = 1024;
+    using Sample = std::array<uint64_t, metric_count>;
+
+    struct Summary {
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t max = 0;
+    };
+
+    FrameStats() = default;
+    // Если задан путь, статистика сохраняется туда при уничтожении:
+    // JSON для файлов *.json, иначе CSV
+    ~FrameStats();
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+    // Копятся в текущий кадр до end_frame()
+    void add_update_time(Clock::duration time);
+    void add_keys(uint64_t count);
+    void end_frame(Clock::duration render_time, Clock::duration flush_time,
+                   uint64_t bytes, uint64_t cells_changed);
+
+    std::size_t size() const { return samples_.size(); }
+    const Sample& sample(std::size_t i) const { return samples_.peek(i); }
+    const Sample& last() const { return samples_.peek(samples_.size() - 1); }
+    Summary summary(FrameMetric metric) const;
+
+    void write_csv(std::ostream& out) const;
+    void write_json(std::ostream& out) const;
+    void dump_on_exit(std::string path) { dump_path_ = std::move(path); }
+
+    static std::string_view name(FrameMetric metric);
+
+  private:
+    RingBuffer<Sample, capacity> samples_;
+    Sample current_{};
+    std::string dump_path_;
+
+    static uint64_t to_us(Clock::duration time);
+};
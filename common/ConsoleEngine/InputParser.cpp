@@ -0,0 +1,193 @@
+#include "InputParser.h"
+
+namespace {
+constexpr std::array<Key, 35> tilde_keys = [] {
+    std::array<Key, 35> keys{};
+    keys[1] = Key::Home;
+    keys[2] = Key::Insert;
+    keys[3] = Key::Delete;
+    keys[4] = Key::End;
+    keys[5] = Key::PageUp;
+    keys[6] = Key::PageDown;
+    keys[7] = Key::Home;
+    keys[8] = Key::End;
+    keys[11] = Key::F1;
+    keys[12] = Key::F2;
+    keys[13] = Key::F3;
+    keys[14] = Key::F4;
+    keys[15] = Key::F5;
+    keys[17] = Key::F6;
+    keys[18] = Key::F7;
+    keys[19] = Key::F8;
+    keys[20] = Key::F9;
+    keys[21] = Key::F10;
+    keys[23] = Key::F11;
+    keys[24] = Key::F12;
+    return keys;
+}();
+
+// Последний байт "\033[A" или "\033OA"
+constexpr std::array<Key, 128> letter_keys = [] {
+    std::array<Key, 128> keys{};
+    keys['A'] = Key::Up;
+    keys['B'] = Key::Down;
+    keys['C'] = Key::Right;
+    keys['D'] = Key::Left;
+    keys['H'] = Key::Home;
+    keys['F'] = Key::End;
+    keys['P'] = Key::F1;
+    keys['Q'] = Key::F2;
+    keys['R'] = Key::F3;
+    keys['S'] = Key::F4;
+    keys['Z'] = Key::Tab;  // Shift+Tab
+    return keys;
+}();
+
+// В xterm модификаторы передаются числом 1 + Shift + 2*Alt + 4*Ctrl
+uint8_t decode_mods(int param) {
+    return param > 1 ? static_cast<uint8_t>((param - 1) & 0x7) : 0;
+}
+}  // namespace
+
+// clang-format off
+const std::array<std::array<InputParser::Transition, InputParser::class_count>,
+                 InputParser::state_count>
+    InputParser::transitions = {{
+    //             Other            Esc                  Bracket               LetterO               Digit               Separator            Intermediate        Final
+    /* Ground */ {{{Ground, EmitByte}, {Escape, StartEscape}, {Ground, EmitByte},   {Ground, EmitByte},   {Ground, EmitByte}, {Ground, EmitByte},  {Ground, EmitByte}, {Ground, EmitByte}}},
+    /* Escape */ {{{Ground, EmitAlt},  {Escape, EmitEscape},  {Csi, StartSequence}, {Ss3, StartSequence}, {Ground, EmitAlt},  {Ground, EmitAlt},   {Ground, EmitAlt},  {Ground, EmitAlt}}},
+    /* Csi    */ {{{Ground, Drop},     {Escape, StartEscape}, {Ground, EmitCsi},    {Ground, EmitCsi},    {Csi, AddDigit},    {Csi, NextParam},    {Csi, MarkUnknown}, {Ground, EmitCsi}}},
+    /* Ss3    */ {{{Ground, Drop},     {Escape, StartEscape}, {Ground, EmitSs3},    {Ground, EmitSs3},    {Ss3, AddDigit},    {Ground, Drop},      {Ground, Drop},     {Ground, EmitSs3}}},
+}};
+// clang-format on
+
+InputParser::Class InputParser::classify(char byte) {
+    unsigned char c = static_cast<unsigned char>(byte);
+    if (c == 0x1b) return Esc;
+    if (c == '[') return Bracket;
+    if (c == 'O') return LetterO;
+    if (c >= '0' && c <= '9') return Digit;
+    if (c == ';') return Separator;
+    if (c >= 0x20 && c <= 0x3f) return Intermediate;
+    if (c >= 0x40 && c <= 0x7e) return Final;
+    return Other;
+}
+
+KeyEvent InputParser::from_byte(char byte) {
+    KeyEvent event;
+    event.ch = byte;
+    switch (byte) {
+        case '\r':
+        case '\n':
+            event.key = Key::Enter;
+            break;
+        case '\t':
+            event.key = Key::Tab;
+            break;
+        case 0x7f:
+        case '\b':
+            event.key = Key::Backspace;
+            break;
+        case 0x1b:
+            event.key = Key::Escape;
+            break;
+        default:
+            event.key = Key::Char;
+            if (byte >= 1 && byte <= 26) {
+                event.ch = static_cast<char>('a' + byte - 1);
+                event.mods = KeyMods::Ctrl;
+            }
+    }
+    return event;
+}
+
+KeyEvent InputParser::from_sequence(char final, bool csi) const {
+    KeyEvent event;
+    if (unknown_) return event;
+    if (csi && final == '~') {
+        if (params_[0] < int(tilde_keys.size()))
+            event.key = tilde_keys[params_[0]];
+        event.mods = decode_mods(params_[1]);
+    } else if (static_cast<unsigned char>(final) < letter_keys.size()) {
+        event.key = letter_keys[static_cast<unsigned char>(final)];
+        // "\033[1;5A" у CSI и "\033O5A" у SS3
+        event.mods = decode_mods(csi ? params_[1] : params_[0]);
+        if (final == 'Z') event.mods |= KeyMods::Shift;
+    }
+    return event;
+}
+
+bool InputParser::feed(char byte, Clock::time_point time, KeyEvent& event) {
+    const Transition& transition = transitions[state_][classify(byte)];
+    state_ = transition.next;
+    switch (transition.action) {
+        case EmitByte:
+            event = from_byte(byte);
+            break;
+        case StartEscape:
+            escape_time_ = time;
+            return false;
+        case StartSequence:
+            params_ = {};
+            param_index_ = 0;
+            sequence_bytes_ = 0;
+            unknown_ = false;
+            return false;
+        case AddDigit: {
+            ++sequence_bytes_;
+            int& param = params_[param_index_];
+            // Длинные числа нам не нужны, главное не переполниться
+            if (param < 1000) param = param * 10 + (byte - '0');
+            return false;
+        }
+        case NextParam:
+            ++sequence_bytes_;
+            if (param_index_ + 1 < int(params_.size())) ++param_index_;
+            return false;
+        case MarkUnknown:
+            ++sequence_bytes_;
+            unknown_ = true;
+            return false;
+        case EmitCsi:
+        case EmitSs3:
+            event = from_sequence(byte, transition.action == EmitCsi);
+            break;
+        case EmitAlt:
+            event = from_byte(byte);
+            event.mods |= KeyMods::Alt;
+            break;
+        case EmitEscape:
+            // Два ESC подряд: первый - клавиша, второй ждет продолжения
+            event = from_byte(0x1b);
+            event.time = escape_time_;
+            escape_time_ = time;
+            return true;
+        case Drop:
+            return false;
+    }
+    event.time = time;
+    return event.key != Key::None;
+}
+
+InputParser::Clock::time_point InputParser::flush_deadline() const {
+    if (state_ == Ground) return Clock::time_point::max();
+    return escape_time_ + escape_timeout;
+}
+
+bool InputParser::flush(Clock::time_point now, KeyEvent& event) {
+    if (state_ == Ground || now - escape_time_ < escape_timeout) return false;
+    State state = state_;
+    state_ = Ground;
+    if (state == Escape) {
+        event = from_byte(0x1b);
+    } else if (sequence_bytes_ == 0) {
+        // После '[' или 'O' ничего не пришло - это была клавиша с Alt
+        event = from_byte(state == Csi ? '[' : 'O');
+        event.mods |= KeyMods::Alt;
+    } else {
+        // Недописанная последовательность уже не придет целиком
+        return false;
+    }
+    event.time = escape_time_;
+    return true;
+}
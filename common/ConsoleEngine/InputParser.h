@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+enum class Key : uint8_t {
+    None,
+    Char,
+    Enter,
+    Escape,
+    Tab,
+    Backspace,
+    Up,
+    Down,
+    Right,
+    Left,
+    Home,
+    End,
+    Insert,
+    Delete,
+    PageUp,
+    PageDown,
+    F1,
+    F2,
+    F3,
+    F4,
+    F5,
+    F6,
+    F7,
+    F8,
+    F9,
+    F10,
+    F11,
+    F12,
+};
+
+namespace KeyMods {
+constexpr uint8_t None = 0;
+constexpr uint8_t Shift = 1 << 0;
+constexpr uint8_t Alt = 1 << 1;
+constexpr uint8_t Ctrl = 1 << 2;
+}  // namespace KeyMods
+
+struct KeyEvent {
+    using Clock = std::chrono::steady_clock;
+
+    Key key = Key::None;
+    // Для Key::Char - сам символ (для Ctrl+буквы - буква), для Enter, Tab,
+    // Backspace и Escape - байт, который их передал
+    char ch = '\0';
+    uint8_t mods = KeyMods::None;
+    Clock::time_point time{};
+};
+
+// Превращает байты из терминала в события клавиш. Последовательность может
+// прийти по частям в разных read(), поэтому состояние хранится между
+// вызовами. Переходы заданы таблицей, память не выделяется
+class InputParser {
+  public:
+    using Clock = KeyEvent::Clock;
+    // Одиночный ESC отличается от начала последовательности только паузой
+    static constexpr Clock::duration escape_timeout =
+        std::chrono::milliseconds(30);
+
+    // true, если байт завершил событие
+    bool feed(char byte, Clock::time_point time, KeyEvent& event);
+    // Завершает зависший ESC, если после него давно ничего не приходило.
+    // Одинокие "ESC [" и "ESC O" - это Alt+'[' и Alt+'O'
+    bool flush(Clock::time_point now, KeyEvent& event);
+    // Когда вызвать flush(), если больше ничего не придет; max(), если
+    // последовательность не начата
+    Clock::time_point flush_deadline() const;
+
+  private:
+    enum State : uint8_t { Ground, Escape, Csi, Ss3, state_count };
+    enum Class : uint8_t {
+        Other,
+        Esc,
+        Bracket,
+        LetterO,
+        Digit,
+        Separator,
+        // Прочие байты параметров и промежуточные (0x20-0x3F), например '?'
+        Intermediate,
+        Final,
+        class_count
+    };
+    enum Action : uint8_t {
+        EmitByte,
+        StartEscape,
+        StartSequence,
+        AddDigit,
+        NextParam,
+        MarkUnknown,
+        EmitCsi,
+        EmitSs3,
+        EmitAlt,
+        EmitEscape,
+        Drop
+    };
+    struct Transition {
+        State next;
+        Action action;
+    };
+
+    static const std::array<std::array<Transition, class_count>, state_count>
+        transitions;
+
+    State state_ = Ground;
+    std::array<int, 2> params_{};
+    int param_index_ = 0;
+    // Сколько байт пришло после "ESC [" или "ESC O"
+    int sequence_bytes_ = 0;
+    // Последовательность не от клавиши (ответ терминала и т.п.): ее байты
+    // глотаем до последнего и не выдаем
+    bool unknown_ = false;
+    Clock::time_point escape_time_{};
+
+    static Class classify(char byte);
+    static KeyEvent from_byte(char byte);
+    KeyEvent from_sequence(char final, bool csi) const;
+};
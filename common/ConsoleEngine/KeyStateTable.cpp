@@ -0,0 +1,46 @@
+#include "KeyStateTable.h"
+
+#include <algorithm>
+#include <cctype>
+
+unsigned char KeyStateTable::index(char key) {
+    // Как и GetAsyncKeyState, регистр букв не различаем
+    return static_cast<unsigned char>(
+        std::toupper(static_cast<unsigned char>(key)));
+}
+
+void KeyStateTable::press(char key, Clock::time_point time) {
+    KeyState& state = keys_[index(key)];
+    Clock::duration since_last = time - state.last_press;
+    if (state.pressed && since_last <= max_repeat_interval) {
+        // Промежуток до первого повтора - задержка, а не период
+        state.repeat_interval =
+            state.repeating ? since_last : Clock::duration::zero();
+        state.repeating = true;
+    } else {
+        state.repeat_interval = Clock::duration::zero();
+        state.repeating = false;
+    }
+    state.last_press = time;
+    state.pressed = true;
+}
+
+bool KeyStateTable::is_down(char key, Clock::time_point time) const {
+    const KeyState& state = keys_[index(key)];
+    if (!state.pressed) return false;
+    Clock::duration timeout = state.repeating
+                                  ? std::max(release_timeout_,
+                                             state.repeat_interval * 3 / 2)
+                                  : repeat_delay_;
+    return time - state.last_press <= timeout;
+}
+
+void KeyStateTable::release_all() { keys_.fill(KeyState()); }
+
+void KeyStateTable::set_release_timeout(Clock::duration timeout) {
+    release_timeout_ = timeout;
+}
+
+void KeyStateTable::set_repeat_delay(Clock::duration delay) {
+    repeat_delay_ = delay;
+}
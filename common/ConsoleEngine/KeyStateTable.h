@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include <chrono>
+
+// Терминал сообщает только о нажатиях, отпускание приходится угадывать:
+// клавиша считается зажатой, пока не истек таймаут с последнего нажатия.
+// После первого нажатия ждем дольше задержки автоповтора (обычно
+// 250-600ms), дальше таймаут подстраивается под период повторов
+class KeyStateTable {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    void press(char key, Clock::time_point time);
+    bool is_down(char key, Clock::time_point time) const;
+    void release_all();
+    void set_release_timeout(Clock::duration timeout);
+    // Сколько держать клавишу после первого нажатия, пока не начался
+    // автоповтор
+    void set_repeat_delay(Clock::duration delay);
+
+  private:
+    struct KeyState {
+        Clock::time_point last_press{};
+        Clock::duration repeat_interval{};
+        bool pressed = false;
+        // Автоповтор уже начался: пришло хотя бы второе нажатие подряд
+        bool repeating = false;
+    };
+    // Нажатия реже этого автоповтором не считаются
+    static constexpr Clock::duration max_repeat_interval =
+        std::chrono::milliseconds(700);
+
+    static unsigned char index(char key);
+
+    std::array<KeyState, 256> keys_{};
+    Clock::duration release_timeout_ = std::chrono::milliseconds(120);
+    Clock::duration repeat_delay_ = std::chrono::milliseconds(650);
+};
@@ -0,0 +1,35 @@
+#include "OutputBudget.h"
+
+#include <algorithm>
+
+namespace {
+double smooth(double average, double sample, double weight) {
+    return average == 0 ? sample : average + weight * (sample - average);
+}
+}  // namespace
+
+void OutputBudget::frame_started(Clock::time_point now) {
+    if (last_frame_ != Clock::time_point()) {
+        double interval = std::chrono::duration<double>(now - last_frame_)
+                              .count();
+        // Паузы в меню не должны раздувать бюджет
+        frame_seconds_ = smooth(frame_seconds_,
+                                std::clamp(interval, 0.001, 0.25), smoothing);
+    }
+    last_frame_ = now;
+}
+
+void OutputBudget::wrote(std::size_t bytes, Clock::duration time) {
+    if (bytes < min_sample) return;
+    double seconds = std::chrono::duration<double>(time).count();
+    // Начинаем с нуля, а не с первого замера: одна запись, застрявшая
+    // из-за планировщика, не должна сразу урезать цвета
+    seconds_per_byte_ += smoothing * (seconds / bytes - seconds_per_byte_);
+}
+
+std::size_t OutputBudget::frame_budget() const {
+    if (seconds_per_byte_ <= 0 || frame_seconds_ <= 0) return unlimited;
+    double budget = frame_seconds_ / seconds_per_byte_;
+    if (budget >= fast_link) return unlimited;
+    return std::max<std::size_t>(budget, min_sample);
+}
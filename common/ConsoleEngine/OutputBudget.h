@@ -0,0 +1,30 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Сколько байт канал до терминала успевает передать за один кадр. Пока
+// буферы ядра и SSH не заполнены, write() возвращается сразу; на
+// медленном канале он блокируется, и время записи показывает реальную
+// скорость
+class OutputBudget {
+  public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t unlimited = SIZE_MAX;
+
+    void frame_started(Clock::time_point now);
+    void wrote(std::size_t bytes, Clock::duration time);
+    // unlimited, пока канал успевает с запасом
+    std::size_t frame_budget() const;
+
+  private:
+    // Мелкие записи уходят в буфер и про скорость ничего не говорят
+    static constexpr std::size_t min_sample = 256;
+    // Больше за кадр игры не выводят - значит, канал не мешает
+    static constexpr std::size_t fast_link = 64 * 1024;
+    static constexpr double smoothing = 0.25;
+
+    double seconds_per_byte_ = 0;
+    double frame_seconds_ = 0;
+    Clock::time_point last_frame_{};
+};
@@ -0,0 +1,84 @@
+#include "RawModeSession.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+
+#include <iterator>
+
+namespace {
+// Для обработчика сигналов: в нем можно только tcsetattr, sigaction и raise
+int interrupted_fd = -1;
+termios interrupted_termios;
+constexpr int handled_signals[] = {SIGINT, SIGTERM, SIGHUP};
+// Обработчики, которые были до сессии, - их вызывает повторный raise
+struct sigaction previous_actions[std::size(handled_signals)];
+
+void restore_on_signal(int sig) {
+    if (interrupted_fd >= 0)
+        tcsetattr(interrupted_fd, TCSANOW, &interrupted_termios);
+    for (std::size_t i = 0; i < std::size(handled_signals); ++i) {
+        if (handled_signals[i] == sig)
+            sigaction(sig, &previous_actions[i], nullptr);
+    }
+    raise(sig);
+}
+}  // namespace
+#endif
+
+std::shared_ptr<RawModeSession> RawModeSession::acquire(int fd) {
+    static std::weak_ptr<RawModeSession> current;
+    if (auto session = current.lock()) return session;
+    std::shared_ptr<RawModeSession> session(new RawModeSession(fd));
+    current = session;
+    return session;
+}
+
+#ifdef _WIN32
+RawModeSession::RawModeSession(int fd) : fd_(fd) { active_ = true; }
+RawModeSession::~RawModeSession() {}
+void RawModeSession::suspend() { active_ = false; }
+void RawModeSession::resume() { active_ = true; }
+#else
+RawModeSession::RawModeSession(int fd) : fd_(fd) {
+    if (!isatty(fd_) || tcgetattr(fd_, &saved_) != 0) return;
+    raw_ = saved_;
+    raw_.c_lflag &= ~(ICANON | ECHO);
+    // VMIN = 0, VTIME = 0: read() сразу возвращает то, что есть. O_NONBLOCK
+    // не ставим - он общий с stdout, если оба смотрят в один tty
+    raw_.c_cc[VMIN] = 0;
+    raw_.c_cc[VTIME] = 0;
+    is_tty_ = true;
+
+    // Ctrl+C не должен оставить терминал без эха
+    interrupted_fd = fd_;
+    interrupted_termios = saved_;
+    struct sigaction action {};
+    action.sa_handler = restore_on_signal;
+    sigemptyset(&action.sa_mask);
+    for (std::size_t i = 0; i < std::size(handled_signals); ++i) {
+        sigaction(handled_signals[i], nullptr, &previous_actions[i]);
+        // Игнорируемый сигнал (например, SIGHUP под nohup) так и остается
+        if (previous_actions[i].sa_handler != SIG_IGN)
+            sigaction(handled_signals[i], &action, nullptr);
+    }
+    resume();
+}
+RawModeSession::~RawModeSession() {
+    suspend();
+    if (!is_tty_) return;
+    for (std::size_t i = 0; i < std::size(handled_signals); ++i)
+        sigaction(handled_signals[i], &previous_actions[i], nullptr);
+    interrupted_fd = -1;
+}
+
+void RawModeSession::suspend() {
+    if (!active_) return;
+    tcsetattr(fd_, TCSANOW, &saved_);
+    active_ = false;
+}
+void RawModeSession::resume() {
+    if (active_ || !is_tty_) return;
+    if (tcsetattr(fd_, TCSANOW, &raw_) == 0) active_ = true;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+// Переводит терминал в неканонический режим без эха на всё время жизни
+// объекта. Режим терминала общий для процесса, поэтому сессия одна на всех:
+// acquire() возвращает уже открытую, если она есть
+class RawModeSession {
+  public:
+    static std::shared_ptr<RawModeSession> acquire(int fd);
+    ~RawModeSession();
+    RawModeSession(const RawModeSession&) = delete;
+    RawModeSession& operator=(const RawModeSession&) = delete;
+
+    // Временно вернуть обычный режим, например для чтения строки
+    void suspend();
+    void resume();
+    bool active() const { return active_; }
+
+  private:
+    explicit RawModeSession(int fd);
+
+    int fd_;
+    bool active_ = false;
+#ifndef _WIN32
+    bool is_tty_ = false;
+    termios saved_{};
+    termios raw_{};
+#endif
+};
@@ -0,0 +1,115 @@
+#include "RenderThread.h"
+
+#include <utility>
+
+namespace {
+constexpr uint64_t viewport_pending = uint64_t(1) << 63;
+constexpr uint64_t scroll_pending = uint64_t(1) << 63;
+
+uint64_t pack_scroll(int top, int bottom, int lines) {
+    return scroll_pending | uint64_t(uint16_t(top)) << 32 |
+           uint64_t(uint16_t(bottom)) << 16 | uint16_t(int16_t(lines));
+}
+}  // namespace
+
+RenderThread::RenderThread(Sink sink, FrameBuffer screen, AnsiEncoder encoder)
+    : sink_(std::move(sink)),
+      screen_(std::move(screen)),
+      encoder_(encoder),
+      thread_(&RenderThread::run, this) {}
+
+RenderThread::~RenderThread() { stop(); }
+
+void RenderThread::submit(const FrameBuffer& frame) {
+    // После первых кадров размеры совпадают и копирование не выделяет память
+    frames_.write_buffer() = frame;
+    if (frames_.publish()) dropped_.fetch_add(1, std::memory_order_relaxed);
+    wake();
+}
+
+void RenderThread::invalidate() {
+    invalidate_.store(true, std::memory_order_relaxed);
+    wake();
+}
+
+void RenderThread::set_viewport(int width, int height) {
+    viewport_.store(viewport_pending | uint64_t(uint32_t(width)) << 32 |
+                        uint32_t(height),
+                    std::memory_order_relaxed);
+    wake();
+}
+
+void RenderThread::scroll(int top, int bottom, int lines) {
+    uint64_t region = pack_scroll(top, bottom, 0);
+    uint64_t current = scroll_.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        // Пока поток не забрал прошлую подсказку для той же области,
+        // сдвиги складываются
+        int pending = 0;
+        if ((current & ~uint64_t(0xffff)) == region)
+            pending = int16_t(current & 0xffff);
+        next = pack_scroll(top, bottom, pending + lines);
+    } while (!scroll_.compare_exchange_weak(current, next,
+                                            std::memory_order_relaxed));
+}
+
+RenderThread::Output RenderThread::take_output() {
+    std::lock_guard lock(output_mutex_);
+    return std::exchange(output_, Output());
+}
+
+void RenderThread::stop() {
+    if (!thread_.joinable()) return;
+    stopping_.store(true, std::memory_order_relaxed);
+    wake();
+    thread_.join();
+}
+
+void RenderThread::wake() {
+    generation_.fetch_add(1, std::memory_order_release);
+    generation_.notify_one();
+}
+
+void RenderThread::run() {
+    uint32_t seen = 0;
+    while (true) {
+        generation_.wait(seen, std::memory_order_acquire);
+        seen = generation_.load(std::memory_order_acquire);
+        bool stopping = stopping_.load(std::memory_order_relaxed);
+
+        if (invalidate_.exchange(false, std::memory_order_relaxed))
+            screen_.fill(FrameBuffer::unknown_cell);
+        uint64_t viewport = viewport_.exchange(0, std::memory_order_relaxed);
+        if (viewport & viewport_pending)
+            encoder_.set_viewport(int(viewport >> 32 & 0x7fffffff),
+                                  int(viewport & 0xffffffff), screen_);
+        uint64_t scroll = scroll_.exchange(0, std::memory_order_relaxed);
+        if (scroll & scroll_pending)
+            encoder_.request_scroll(int(scroll >> 32 & 0xffff),
+                                    int(scroll >> 16 & 0xffff),
+                                    int16_t(scroll & 0xffff));
+        if (frames_.acquire()) {
+            auto start = Clock::now();
+            budget_.frame_started(start);
+            int changed = encoder_.encode_frame(
+                out_, frames_.read_buffer(), screen_, budget_.frame_budget());
+            auto encoded = Clock::now();
+            auto flushed = encoded;
+            if (!out_.empty()) {
+                sink_(out_);
+                flushed = Clock::now();
+                budget_.wrote(out_.size(), flushed - encoded);
+            }
+            {
+                std::lock_guard lock(output_mutex_);
+                output_.render_time += encoded - start;
+                output_.flush_time += flushed - encoded;
+                output_.bytes += out_.size();
+                output_.cells_changed += changed;
+            }
+            out_.clear();
+        }
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "AnsiEncoder.h"
+#include "FrameBuffer.h"
+#include "OutputBudget.h"
+#include "TripleBuffer.h"
+
+// Кодирует и выводит кадры в отдельном потоке, чтобы игровой цикл не ждал
+// терминал. Если вывод не успевает, промежуточные кадры пропускаются
+class RenderThread {
+  public:
+    using Sink = std::function<void(std::string_view)>;
+    using Clock = std::chrono::steady_clock;
+
+    // Сколько заняли кадры, выведенные потоком с прошлого take_output()
+    struct Output {
+        Clock::duration render_time{};
+        Clock::duration flush_time{};
+        uint64_t bytes = 0;
+        uint64_t cells_changed = 0;
+    };
+
+    // screen и encoder - текущее состояние терминала, поток продолжает с него
+    RenderThread(Sink sink, FrameBuffer screen, AnsiEncoder encoder);
+    ~RenderThread();
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void submit(const FrameBuffer& frame);
+    // Следующий кадр будет выведен целиком
+    void invalidate();
+    void set_viewport(int width, int height);
+    // Подсказка для следующего кадра, см. AnsiEncoder::request_scroll
+    void scroll(int top, int bottom, int lines);
+    // Выводит последний отправленный кадр и останавливает поток
+    void stop();
+
+    // После stop() - что показано в терминале
+    const FrameBuffer& screen() const { return screen_; }
+    const AnsiEncoder& encoder() const { return encoder_; }
+    uint64_t dropped_frames() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+    // Забирает накопленные замеры; кадр обычно выводится уже после
+    // present(), поэтому замеры приходят со следующим кадром
+    Output take_output();
+
+  private:
+    Sink sink_;
+    FrameBuffer screen_;
+    AnsiEncoder encoder_;
+    std::string out_;
+    OutputBudget budget_;
+    TripleBuffer<FrameBuffer> frames_;
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> invalidate_{false};
+    // Старший бит - новый размер еще не применен
+    std::atomic<uint64_t> viewport_{0};
+    // Так же: старший бит, затем по 16 бит top, bottom и lines
+    std::atomic<uint64_t> scroll_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::mutex output_mutex_;
+    Output output_;
+    std::thread thread_;
+
+    void run();
+    void wake();
+};
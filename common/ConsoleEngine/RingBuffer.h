@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+// Кольцевой буфер фиксированного размера, без выделений памяти
+template <typename T, std::size_t N>
+class RingBuffer {
+    static_assert((N & (N - 1)) == 0, "RingBuffer size must be a power of 2");
+
+  public:
+    bool push(T value) {
+        if (full()) return false;
+        data_[(head_ + size_) & (N - 1)] = value;
+        ++size_;
+        return true;
+    }
+    T pop() {
+        T value = data_[head_];
+        head_ = (head_ + 1) & (N - 1);
+        --size_;
+        return value;
+    }
+    const T& peek(std::size_t i = 0) const {
+        return data_[(head_ + i) & (N - 1)];
+    }
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+    std::size_t size() const { return size_; }
+    std::size_t free_space() const { return N - size_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == N; }
+    static constexpr std::size_t capacity() { return N; }
+
+  private:
+    std::array<T, N> data_{};
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+};
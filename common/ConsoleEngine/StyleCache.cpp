@@ -0,0 +1,37 @@
+#include "StyleCache.h"
+
+#include <algorithm>
+
+namespace {
+// Цвет без соответствующего атрибута не виден и в ключ не входит
+uint32_t style_key(const ConsoleCell& style, ColorDepth depth) {
+    uint32_t key = style.attrs | uint32_t(depth) << 24;
+    if (style.attrs & CellAttrs::TextColor) key |= uint32_t(style.fg.id) << 8;
+    if (style.attrs & CellAttrs::BkgColor) key |= uint32_t(style.bg.id) << 16;
+    return key;
+}
+}  // namespace
+
+int StyleCache::intern(const ConsoleCell& style, ColorDepth depth) {
+    uint32_t key = style_key(style, depth);
+    auto it = std::find(keys_.begin(), keys_.end(), key);
+    if (it != keys_.end()) return int(it - keys_.begin()) + 1;
+    if (int(keys_.size()) + 1 >= max_styles) return -1;
+    keys_.push_back(key);
+    return int(keys_.size());
+}
+
+std::string_view StyleCache::find(int from, int to) const {
+    if (spans_.empty()) return {};
+    const Span& span = spans_[from * max_styles + to];
+    return std::string_view(bytes_).substr(span.offset, span.size);
+}
+
+void StyleCache::store(int from, int to, std::string_view sequence) {
+    // Смещения 16-битные; переходов столько не бывает, но на всякий случай
+    if (bytes_.size() + sequence.size() > UINT16_MAX) return;
+    if (spans_.empty()) spans_.resize(max_styles * max_styles);
+    spans_[from * max_styles + to] = {uint16_t(bytes_.size()),
+                                      uint8_t(sequence.size())};
+    bytes_ += sequence;
+}
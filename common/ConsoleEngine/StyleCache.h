@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FrameBuffer.h"
+
+// Готовые последовательности SGR для смены оформления ячеек. Оформлений в
+// игре немного ('.' зеленым, '~' синим и т.д.), поэтому каждое получает
+// маленький номер, а переход "из a в b" кодируется один раз и дальше
+// просто копируется из общего буфера
+class StyleCache {
+  public:
+    // Номер для "оформление терминала неизвестно"
+    static constexpr int unknown = 0;
+    static constexpr int max_styles = 64;
+
+    // Номер оформления ячейки (символ не учитывается); -1, если таблица
+    // заполнена - тогда последовательность собирается как обычно
+    int intern(const ConsoleCell& style, ColorDepth depth);
+    // Пустая строка, если переход еще не закодирован
+    std::string_view find(int from, int to) const;
+    void store(int from, int to, std::string_view sequence);
+
+  private:
+    struct Span {
+        uint16_t offset = 0;
+        uint8_t size = 0;
+    };
+
+    // keys_[id - 1] - упакованные цвета, атрибуты и глубина цвета
+    std::vector<uint32_t> keys_;
+    // max_styles x max_styles, выделяется при первом сохранении
+    std::vector<Span> spans_;
+    std::string bytes_;
+};
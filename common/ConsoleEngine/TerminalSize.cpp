@@ -0,0 +1,103 @@
+#include "TerminalSize.h"
+
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+// Явная настройка пользователя; false, если не задана
+bool color_depth_override(ColorDepth& depth) {
+    const char* value = std::getenv("CONSOLE_ENGINE_COLORS");
+    if (!value) return false;
+    std::string_view colors = value;
+    if (colors == "256") {
+        depth = ColorDepth::Ansi256;
+    } else if (colors == "16") {
+        depth = ColorDepth::Ansi16;
+    } else if (colors == "mono") {
+        depth = ColorDepth::Mono;
+    } else {
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+
+bool TerminalWindow::query_size(int, TerminalSize& size) {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+        return false;
+    size.width = info.srWindow.Right - info.srWindow.Left + 1;
+    size.height = info.srWindow.Bottom - info.srWindow.Top + 1;
+    return true;
+}
+
+void TerminalWindow::watch_resize() {}
+
+bool TerminalWindow::size_may_have_changed(unsigned&) { return true; }
+
+ColorDepth TerminalWindow::color_depth() {
+    ColorDepth depth;
+    if (color_depth_override(depth)) return depth;
+    // Консоль с ENABLE_VIRTUAL_TERMINAL_PROCESSING понимает 256 цветов
+    return ColorDepth::Ansi256;
+}
+#else
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <atomic>
+
+namespace {
+std::atomic<unsigned> resize_generation{1};
+static_assert(std::atomic<unsigned>::is_always_lock_free);
+
+void on_resize(int) {
+    resize_generation.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace
+
+bool TerminalWindow::query_size(int fd, TerminalSize& size) {
+    winsize ws{};
+    if (ioctl(fd, TIOCGWINSZ, &ws) != 0 || ws.ws_col == 0) return false;
+    size.width = ws.ws_col;
+    size.height = ws.ws_row;
+    return true;
+}
+
+void TerminalWindow::watch_resize() {
+    static bool installed = false;
+    if (installed) return;
+    installed = true;
+    struct sigaction action {};
+    action.sa_handler = on_resize;
+    sigemptyset(&action.sa_mask);
+    // read() и write() не должны прерываться из-за смены размера
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &action, nullptr);
+}
+
+bool TerminalWindow::size_may_have_changed(unsigned& seen_generation) {
+    unsigned generation = resize_generation.load(std::memory_order_relaxed);
+    if (generation == seen_generation) return false;
+    seen_generation = generation;
+    return true;
+}
+
+ColorDepth TerminalWindow::color_depth() {
+    ColorDepth depth;
+    if (color_depth_override(depth)) return depth;
+    const char* env_term = std::getenv("TERM");
+    std::string_view term = env_term ? env_term : "";
+    // Понижаем только для терминалов, которые точно слабее. "xterm" или
+    // пустой TERM ничего не доказывают: почти все эмуляторы знают 256 цветов
+    if (term == "dumb" || term.starts_with("vt")) return ColorDepth::Mono;
+    if (term == "linux" || term == "ansi" || term.starts_with("cons"))
+        return ColorDepth::Ansi16;
+    return ColorDepth::Ansi256;
+}
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+#include "ConsoleColors.h"
+
+struct TerminalSize {
+    int width = 0;
+    int height = 0;
+    bool operator==(const TerminalSize& other) const = default;
+};
+
+// Размер окна терминала. Обработчик SIGWINCH только увеличивает счетчик,
+// сам размер запрашивается при следующей проверке
+namespace TerminalWindow {
+// false, если fd - не терминал
+bool query_size(int fd, TerminalSize& size);
+void watch_resize();
+// Был ли SIGWINCH с прошлой проверки. На Windows сигнала нет, там размер
+// приходится запрашивать каждый раз
+bool size_may_have_changed(unsigned& seen_generation);
+// Сколько цветов понимает терминал. По умолчанию 256, меньше - только для
+// заведомо слабых TERM (dumb, vt*, linux). CONSOLE_ENGINE_COLORS=256, 16
+// или mono задает явно
+ColorDepth color_depth();
+}  // namespace TerminalWindow
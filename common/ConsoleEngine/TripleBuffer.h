@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Передача кадров между двумя потоками без блокировок. Писатель всегда
+// заполняет свой слот, читатель забирает самый свежий опубликованный.
+// Если читатель не успел, старый кадр просто заменяется новым
+template <typename T>
+class TripleBuffer {
+  public:
+    T& write_buffer() { return slots_[write_]; }
+    // Возвращает true, если предыдущий кадр так и не был прочитан
+    bool publish() {
+        uint8_t previous =
+            middle_.exchange(write_ | fresh_bit, std::memory_order_acq_rel);
+        write_ = previous & index_mask;
+        return previous & fresh_bit;
+    }
+
+    // Забирает последний опубликованный кадр, если он новый
+    bool acquire() {
+        if (!(middle_.load(std::memory_order_relaxed) & fresh_bit))
+            return false;
+        uint8_t previous = middle_.exchange(read_, std::memory_order_acq_rel);
+        read_ = previous & index_mask;
+        return true;
+    }
+    const T& read_buffer() const { return slots_[read_]; }
+
+  private:
+    static constexpr uint8_t index_mask = 0x3;
+    static constexpr uint8_t fresh_bit = 0x4;
+
+    std::array<T, 3> slots_{};
+    uint8_t write_ = 0;
+    uint8_t read_ = 1;
+    std::atomic<uint8_t> middle_{2};
+};
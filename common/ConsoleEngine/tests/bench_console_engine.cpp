@@ -0,0 +1,182 @@
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "ConsoleEngine.h"
+
+// Простые замеры без внешних зависимостей. Запускать из Release-сборки:
+// ConsoleEngineBench
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Чтобы компилятор не выкинул результат
+volatile std::size_t sink = 0;
+
+template <typename F>
+void run(const char* name, int iterations, int ops_per_iteration, F&& body) {
+    body();  // прогрев
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) body();
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                            start);
+    std::printf("%-40s %10.2f ns/op\n", name,
+                elapsed.count() / (double(iterations) * ops_per_iteration));
+}
+
+// Один кадр - body(frame). Кроме времени считаем, сколько байт ушло
+// в терминал
+template <typename F>
+void run_frames(const char* name, int frames, std::ostringstream& out,
+                F&& body) {
+    body(0);  // прогрев, первый кадр всегда полный
+    out.str("");
+    auto start = Clock::now();
+    for (int i = 1; i <= frames; ++i) body(i);
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                            start);
+    std::printf("%-40s %10.2f ns/frame %10.1f bytes/frame\n", name,
+                elapsed.count() / frames, double(out.tellp()) / frames);
+}
+
+// Карта MyGarden по умолчанию: трава, вода, камни и растения
+ConsoleCell garden_cell(int x, int y) {
+    switch ((x * 7 + y * 13) % 11) {
+        case 0:
+            return ConsoleCell('~', Colors256::Blue);
+        case 1:
+            return ConsoleCell('#', Colors256::Gray50);
+        case 2:
+            return ConsoleCell('*', Colors256::Red);
+        default:
+            return ConsoleCell('.', Colors256::Green);
+    }
+}
+
+void draw_garden(ConsoleEngine& engine, int width, int height) {
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            engine.set_cell(x, y, garden_cell(x, y));
+}
+
+void bench_frames() {
+    constexpr int frames = 2000;
+    std::istringstream in;
+    std::ostringstream out;
+
+    {
+        constexpr int width = 100, height = 20;
+        ConsoleEngine engine(in, out);
+        engine.resize_buffer(width, height);
+        run_frames("MyGarden 100x20 full redraw", frames, out, [&](int) {
+            draw_garden(engine, width, height);
+            engine.invalidate();
+            engine.present();
+        });
+    }
+    {
+        // Дорога CarRacing 15x20 со счетом сверху; каждый кадр сдвигается
+        constexpr int width = 15, height = 20;
+        ConsoleEngine engine(in, out);
+        engine.resize_buffer(24, height + 2);
+        run_frames("CarRacing 15x20 road frame", frames, out, [&](int frame) {
+            engine.draw_text(0, 0, "Best score: 1234");
+            engine.draw_text(0, 1, "Score: " + std::to_string(frame));
+            for (int y = 0; y < height; ++y) {
+                std::string row(width, '.');
+                int car = (y + frame) % 9;
+                if (car < 4) row.replace(3 * ((y + frame) % 5), 3, "TTT");
+                engine.draw_text(0, y + 2, row);
+            }
+            engine.present();
+        });
+    }
+    {
+        // Меню MyGarden поверх карты: открыть, выбрать пункт, закрыть
+        constexpr int width = 100, height = 20;
+        ConsoleEngine engine(in, out);
+        engine.resize_buffer(width, height);
+        draw_garden(engine, width, height);
+        engine.present();
+        const std::string_view options[] = {"Plant", "Water", "Dig", "Exit"};
+        run_frames("Menu overlay open/select/close", frames, out,
+                   [&](int frame) {
+                       constexpr int menu_x = 40, menu_y = 5;
+                       constexpr int menu_w = 20, menu_h = 6;
+                       if (frame % 3 == 2) {
+                           draw_garden(engine, width, height);
+                           engine.present();
+                           return;
+                       }
+                       for (int y = 0; y < menu_h; ++y) {
+                           bool border = y == 0 || y == menu_h - 1;
+                           std::string row(menu_w, border ? '#' : ' ');
+                           row.front() = row.back() = '#';
+                           engine.draw_text(menu_x, menu_y + y, row);
+                       }
+                       for (int i = 0; i < 4; ++i) {
+                           ConsoleCell style;
+                           if (i == frame % 4)
+                               style.set_background_color(Colors256::Gray50);
+                           engine.draw_text(menu_x + 7, menu_y + 1 + i,
+                                            options[i], style);
+                       }
+                       engine.present();
+                   });
+    }
+    {
+        constexpr int width = 100, height = 20;
+        ConsoleEngine engine(in, out);
+        engine.resize_buffer(width, height);
+        draw_garden(engine, width, height);
+        engine.present();
+        run_frames("Sparse single-cell update", frames * 10, out,
+                   [&](int frame) {
+                       int x = (frame * 37) % width, y = (frame * 11) % height;
+                       engine.set_cell(x, y, ConsoleCell('@', Colors256::Red));
+                       engine.present();
+                       engine.set_cell(x, y, garden_cell(x, y));
+                   });
+    }
+}
+
+void bench_color_encoding() {
+    constexpr int iterations = 2000;
+    std::ostringstream stream_out;
+    run("Color256 via ostream formatting", iterations, 256, [&] {
+        stream_out.str("");
+        for (int id = 0; id < 256; ++id)
+            stream_out << "\033[38;5;" << id << "m";
+        sink = sink + stream_out.tellp();
+    });
+
+    std::istringstream in;
+    std::ostringstream out;
+    ConsoleEngine engine(in, out);
+    run("Color256 via ConsoleEngine tables", iterations, 256, [&] {
+        out.str("");
+        ConsoleFrame frame(engine);
+        for (int id = 0; id < 256; ++id) engine.set_text_color(id);
+    });
+
+    run("Cursor via ostream formatting", iterations, 256, [&] {
+        stream_out.str("");
+        for (int i = 0; i < 256; ++i)
+            stream_out << "\033[" << (i % 40 + 1) << ";" << (i + 1) << "H";
+        sink = sink + stream_out.tellp();
+    });
+    run("Cursor via ConsoleEngine to_chars", iterations, 256, [&] {
+        out.str("");
+        ConsoleFrame frame(engine);
+        for (int i = 0; i < 256; ++i) engine.set_cursor_to_pos(i, i % 40);
+    });
+}
+}  // namespace
+
+int main() {
+    bench_color_encoding();
+    bench_frames();
+    return 0;
+}
@@ -1,10 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "ConsoleEngine.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 class ConsoleEngineTest : public ::testing::Test {
   protected:
     std::istringstream in{""};
@@ -110,4 +118,902 @@ TEST_F(ConsoleEngineTest, Get) {
     in.str("aadd\nwwss");
     EXPECT_EQ(engine->get(), "aadd");
     EXPECT_EQ(engine->get(), "wwss");
-}
\ No newline at end of file
+}
+TEST_F(ConsoleEngineTest, PresentSendsAllCellsFirstTime) {
+    engine->resize_buffer(2, 1);
+    engine->set_cell(0, 0, 'a');
+    engine->set_cell(1, 0, ConsoleCell('b', Colors256::Red));
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[H\033[0ma\033[38;5;196mb\033[0m");
+}
+
+TEST_F(ConsoleEngineTest, PresentSendsOnlyChangedCells) {
+    engine->resize_buffer(3, 2);
+    engine->present();
+    clear_out();
+    engine->present();
+    EXPECT_EQ(out.str(), "");
+    engine->set_cell(2, 1, 'x');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[2;3Hx");
+}
+
+TEST_F(ConsoleEngineTest, ClearMakesFrontBufferBlank) {
+    engine->resize_buffer(2, 1);
+    engine->clear();
+    clear_out();
+    engine->set_cell(1, 0, 'x');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[C\033[0mx");
+}
+
+TEST_F(ConsoleEngineTest, InvalidateRepaintsEverything) {
+    engine->resize_buffer(2, 1);
+    engine->present();
+    clear_out();
+    engine->invalidate();
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[H  ");
+}
+
+TEST_F(ConsoleEngineTest, DrawTextIsClipped) {
+    engine->resize_buffer(3, 1);
+    engine->draw_text(1, 0, "abc");
+    EXPECT_EQ(engine->get_cell(1, 0).glyph, 'a');
+    EXPECT_EQ(engine->get_cell(2, 0).glyph, 'b');
+}
+
+TEST_F(ConsoleEngineTest, FrameBuffersOutputUntilEnd) {
+    engine->begin_frame();
+    engine->set_cursor_to_pos(1, 2);
+    engine->print_color(ConsoleTextColors::Red, "Hi", 42);
+    engine->hide_cursor();
+    EXPECT_EQ(out.str(), "");
+    engine->end_frame();
+    EXPECT_EQ(out.str(), "\033[3;2H\033[31mHi42\033[0m\033[?25l");
+}
+
+TEST_F(ConsoleEngineTest, NestedFramesWriteOnOutermostEnd) {
+    {
+        ConsoleFrame outer(*engine);
+        {
+            ConsoleFrame inner(*engine);
+            engine->clear();
+        }
+        EXPECT_EQ(out.str(), "");
+        engine->print('x');
+    }
+    EXPECT_EQ(out.str(), "\033[2J\033[Hx");
+}
+
+TEST_F(ConsoleEngineTest, GetNoWait) {
+    EXPECT_EQ(engine->get_no_wait(), '\0');
+    in.str("ws");
+    EXPECT_EQ(engine->get_no_wait(), 'w');
+    EXPECT_EQ(engine->get_no_wait(), 's');
+    EXPECT_EQ(engine->get_no_wait(), '\0');
+}
+
+TEST_F(ConsoleEngineTest, DrainKeysReturnsAllPending) {
+    EXPECT_EQ(engine->drain_keys(), "");
+    in.str("wasd\r");
+    EXPECT_EQ(engine->drain_keys(), "wasd\r");
+    EXPECT_EQ(engine->drain_keys(), "");
+}
+
+TEST_F(ConsoleEngineTest, DrainKeysLongerThanRingBuffer) {
+    std::string keys(1000, 'a');
+    in.str(keys);
+    EXPECT_EQ(engine->drain_keys(), keys);
+}
+
+TEST(RingBufferTest, WrapsAround) {
+    RingBuffer<int, 4> ring;
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.push(i));
+    EXPECT_FALSE(ring.push(4));
+    EXPECT_EQ(ring.pop(), 0);
+    EXPECT_TRUE(ring.push(4));
+    for (int i = 1; i <= 4; ++i) EXPECT_EQ(ring.pop(), i);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST_F(ConsoleEngineTest, KeyPressedDoesNotConsumeInput) {
+    in.str("a");
+    EXPECT_TRUE(engine->key_pressed('A'));
+    EXPECT_FALSE(engine->key_pressed('D'));
+    EXPECT_TRUE(engine->key_pressed('a'));
+    EXPECT_EQ(engine->drain_keys(), "a");
+}
+
+TEST_F(ConsoleEngineTest, SeveralKeysInOneFrame) {
+    in.str("ad");
+    EXPECT_TRUE(engine->key_pressed('A'));
+    EXPECT_TRUE(engine->key_pressed('D'));
+}
+
+TEST(KeyStateTableTest, ReleasedAfterTimeout) {
+    using namespace std::chrono_literals;
+    KeyStateTable keys;
+    keys.set_repeat_delay(100ms);
+    KeyStateTable::Clock::time_point t0{};
+    keys.press('w', t0 + 1s);
+    EXPECT_TRUE(keys.is_down('w', t0 + 1s + 50ms));
+    EXPECT_FALSE(keys.is_down('w', t0 + 1s + 150ms));
+    EXPECT_FALSE(keys.is_down('s', t0 + 1s));
+}
+
+TEST(KeyStateTableTest, AutorepeatExtendsTimeout) {
+    using namespace std::chrono_literals;
+    KeyStateTable keys;
+    keys.set_release_timeout(50ms);
+    KeyStateTable::Clock::time_point t0{};
+    keys.press('w', t0 + 1s);
+    keys.press('w', t0 + 1s + 500ms);
+    keys.press('w', t0 + 1s + 600ms);
+    // период автоповтора 100ms, держим до 150ms после последнего нажатия
+    EXPECT_TRUE(keys.is_down('w', t0 + 1s + 720ms));
+    EXPECT_FALSE(keys.is_down('w', t0 + 1s + 760ms));
+}
+
+TEST(KeyStateTableTest, HeldUntilFirstRepeat) {
+    using namespace std::chrono_literals;
+    KeyStateTable keys;
+    KeyStateTable::Clock::time_point t0{};
+    keys.press('d', t0);
+    // Автоповтор начинается только через полсекунды
+    for (auto t = 0ms; t < 500ms; t += 50ms)
+        EXPECT_TRUE(keys.is_down('d', t0 + t)) << t.count();
+    keys.press('d', t0 + 500ms);
+    EXPECT_TRUE(keys.is_down('d', t0 + 530ms));
+    keys.press('d', t0 + 533ms);
+    keys.press('d', t0 + 566ms);
+    EXPECT_TRUE(keys.is_down('d', t0 + 650ms));
+    // После отпускания повторы прекратились
+    EXPECT_FALSE(keys.is_down('d', t0 + 700ms));
+    // Одиночное нажатие отпускается после задержки автоповтора
+    keys.press('a', t0);
+    EXPECT_FALSE(keys.is_down('a', t0 + 700ms));
+}
+
+TEST_F(ConsoleEngineTest, ImmediateColorsFollowDepth) {
+    engine->set_color_depth(ColorDepth::Ansi16);
+    engine->print_color(Colors256::Blue, Colors256::Gray50, "x");
+    EXPECT_EQ(out.str().find("38;5;"), std::string::npos);
+    EXPECT_EQ(out.str().find("48;5;"), std::string::npos);
+    EXPECT_NE(out.str().find('x'), std::string::npos);
+
+    clear_out();
+    engine->set_color_depth(ColorDepth::Mono);
+    engine->set_text_color(Colors256::Blue);
+    engine->set_color(ConsoleTextColors::Red);
+    EXPECT_EQ(out.str(), "");
+    // Выделение фоном остается заметным - инверсией
+    engine->print_color(ConsoleBkgColors::Red, "y");
+    EXPECT_EQ(out.str(), "\033[7my\033[0m");
+
+    clear_out();
+    engine->set_color_depth(ColorDepth::Ansi256);
+    engine->set_text_color(Colors256::Blue);
+    EXPECT_EQ(out.str(), "\033[38;5;21m");
+}
+
+TEST_F(ConsoleEngineTest, PresentSendsStyleOncePerRun) {
+    engine->resize_buffer(4, 1);
+    for (int x = 0; x < 4; ++x)
+        engine->set_cell(x, 0, ConsoleCell('~', Colors256::Blue));
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[H\033[0;38;5;21m~~~~\033[0m");
+}
+
+TEST_F(ConsoleEngineTest, PresentSendsOnlyChangedStyleParams) {
+    engine->resize_buffer(3, 1);
+    ConsoleCell cell('.', Colors256::Green);
+    engine->set_cell(0, 0, cell);
+    cell.set_background_color(Colors256::Gray80);
+    engine->set_cell(1, 0, cell);
+    cell.set_style(ConsoleStyle::Inverse);
+    engine->set_cell(2, 0, cell);
+    engine->present();
+    EXPECT_EQ(out.str(),
+              "\033[H\033[0;38;5;46m.\033[48;5;248m.\033[7m.\033[0m");
+}
+
+TEST_F(ConsoleEngineTest, ImmediateColorsForgetTrackedStyle) {
+    engine->resize_buffer(2, 1);
+    engine->present();
+    engine->set_cell(0, 0, 'a');
+    engine->set_color(ConsoleTextColors::Red);
+    clear_out();
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[H\033[0ma");
+}
+
+class CursorMotionTest : public ConsoleEngineTest {
+  protected:
+    void SetUp() override {
+        ConsoleEngineTest::SetUp();
+        engine->resize_buffer(20, 4);
+        engine->present();
+        engine->set_cursor_to_pos(0, 0);
+        clear_out();
+    }
+};
+
+TEST_F(CursorMotionTest, NoMoveWhenAlreadyThere) {
+    engine->set_cell(0, 0, 'a');
+    engine->present();
+    EXPECT_EQ(out.str(), "a");
+}
+
+TEST_F(CursorMotionTest, OverprintsKnownCellsForShortGaps) {
+    engine->set_cell(0, 0, 'a');
+    engine->set_cell(3, 0, 'b');
+    engine->present();
+    EXPECT_EQ(out.str(), "a  b");
+}
+
+TEST_F(CursorMotionTest, RelativeMoveForLongGaps) {
+    engine->set_cell(0, 0, 'a');
+    engine->set_cell(15, 0, 'b');
+    engine->present();
+    EXPECT_EQ(out.str(), "a\033[14Cb");
+}
+
+TEST_F(CursorMotionTest, LineFeedToStartOfNextRow) {
+    engine->set_cell(5, 0, 'a');
+    engine->set_cell(0, 1, 'b');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[5Ca\r\nb");
+}
+
+TEST_F(CursorMotionTest, AbsoluteWhenCursorUnknown) {
+    engine->print("text");
+    clear_out();
+    engine->set_cell(4, 2, 'a');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[3;5Ha");
+}
+
+TEST_F(ConsoleEngineTest, SetColor256) {
+    engine->set_text_color(Colors256::Red);
+    EXPECT_EQ(out.str(), "\033[38;5;196m");
+    clear_out();
+    engine->set_background_color(Colors256::Black);
+    EXPECT_EQ(out.str(), "\033[48;5;0m");
+    clear_out();
+    engine->set_cursor_to_pos(1234, 99);
+    EXPECT_EQ(out.str(), "\033[100;1235H");
+}
+
+TEST(TripleBufferTest, ReaderGetsLatestFrame) {
+    TripleBuffer<int> frames;
+    EXPECT_FALSE(frames.acquire());
+    frames.write_buffer() = 1;
+    EXPECT_FALSE(frames.publish());
+    frames.write_buffer() = 2;
+    EXPECT_TRUE(frames.publish());
+    EXPECT_TRUE(frames.acquire());
+    EXPECT_EQ(frames.read_buffer(), 2);
+    EXPECT_FALSE(frames.acquire());
+}
+
+TEST_F(ConsoleEngineTest, RenderThreadOutputsLastFrame) {
+    engine->resize_buffer(2, 1);
+    engine->start_render_thread();
+    engine->set_cell(0, 0, 'a');
+    engine->present();
+    engine->set_cell(1, 0, 'b');
+    engine->present();
+    engine->stop_render_thread();
+    EXPECT_NE(out.str().find('b'), std::string::npos);
+
+    // Состояние терминала вернулось движку
+    clear_out();
+    engine->present();
+    EXPECT_EQ(out.str(), "");
+}
+
+TEST(FrameRecordingTest, ReplaysRecordedFrames) {
+    using namespace std::chrono_literals;
+    std::stringstream file;
+    FrameRecorder recorder(file);
+    FrameRecorder::Clock::time_point start{};
+    FrameBuffer frame(4, 2);
+    recorder.record(frame, start);
+    frame.at(1, 1) = ConsoleCell('x', Colors256::Red, Colors256::Blue);
+    recorder.record(frame, start + 40ms);
+    frame.resize(5, 2);
+    recorder.record(frame, start + 50ms);
+
+    FramePlayer player(file);
+    ASSERT_TRUE(player.next());
+    EXPECT_EQ(player.frame().at(1, 1), ConsoleCell());
+    ASSERT_TRUE(player.next());
+    EXPECT_EQ(player.delay(), 40ms);
+    EXPECT_EQ(player.frame().at(1, 1),
+              ConsoleCell('x', Colors256::Red, Colors256::Blue));
+    ASSERT_TRUE(player.next());
+    EXPECT_EQ(player.frame().width(), 5);
+    EXPECT_EQ(player.frame().at(1, 1),
+              ConsoleCell('x', Colors256::Red, Colors256::Blue));
+    EXPECT_FALSE(player.next());
+}
+
+TEST(FrameRecordingTest, UnchangedFrameTakesFewBytes) {
+    std::stringstream file;
+    FrameRecorder recorder(file);
+    FrameBuffer frame(80, 24);
+    recorder.record(frame);
+    auto size = file.str().size();
+    recorder.record(frame);
+    EXPECT_LE(file.str().size() - size, 6u);
+}
+
+TEST(FrameRecordingTest, RejectsOtherFiles) {
+    std::stringstream file("not a recording");
+    EXPECT_THROW(FramePlayer player(file), std::runtime_error);
+}
+
+TEST(FrameRecordingTest, RejectsHugeFrames) {
+    std::stringstream file;
+    FrameRecorder recorder(file);
+    // Кадр 1x1, затем испорченный: ширина 2^40
+    recorder.record(FrameBuffer(1, 1));
+    file << char(0) << "\x80\x80\x80\x80\x80\x20" << char(1) << char(0);
+
+    FramePlayer player(file);
+    ASSERT_TRUE(player.next());
+    EXPECT_THROW(player.next(), std::runtime_error);
+}
+
+TEST_F(ConsoleEngineTest, PresentRecordsFrames) {
+    std::stringstream file;
+    engine->start_recording(file);
+    engine->resize_buffer(2, 1);
+    engine->set_cell(0, 0, 'a');
+    engine->present();
+    engine->stop_recording();
+
+    FramePlayer player(file);
+    ASSERT_TRUE(player.next());
+    EXPECT_EQ(player.frame().at(0, 0), ConsoleCell('a'));
+}
+
+TEST(AnsiEncoderTest, ViewportClipsFrame) {
+    AnsiEncoder encoder;
+    FrameBuffer frame(4, 2, ConsoleCell('x'));
+    FrameBuffer screen(4, 2, FrameBuffer::unknown_cell);
+    encoder.set_viewport(2, 1, screen);
+    std::string out;
+    encoder.encode_frame(out, frame, screen);
+    EXPECT_EQ(out, "\033[H\033[0mxx");
+    EXPECT_EQ(screen.at(2, 0), FrameBuffer::unknown_cell);
+}
+
+TEST(AnsiEncoderTest, GrowingViewportRepaintsOnlyExposedCells) {
+    AnsiEncoder encoder;
+    FrameBuffer frame(3, 1, ConsoleCell('x'));
+    FrameBuffer screen(3, 1, FrameBuffer::unknown_cell);
+    std::string out;
+    encoder.encode_frame(out, frame, screen);
+    encoder.set_viewport(2, 1, screen);
+    encoder.set_viewport(3, 1, screen);
+    out.clear();
+    encoder.encode_frame(out, frame, screen);
+    EXPECT_EQ(out, "\033[1;3Hx");
+}
+
+TEST_F(ConsoleEngineTest, RestoreRegionRepaintsOnlyOverlay) {
+    engine->resize_buffer(6, 3);
+    engine->fill_rect(0, 0, 6, 3, '.');
+    engine->present();
+    SavedRegion covered = engine->save_region(1, 0, 3, 3);
+    engine->draw_rect(1, 0, 3, 3, '#');
+    EXPECT_EQ(engine->get_cell(2, 1), ConsoleCell('.'));
+    EXPECT_EQ(engine->get_cell(3, 2), ConsoleCell('#'));
+    engine->present();
+    clear_out();
+
+    engine->restore_region(covered);
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[1;2H...\r\n\033[C...\r\n\033[C...");
+}
+
+TEST_F(ConsoleEngineTest, RectsAreClipped) {
+    engine->resize_buffer(3, 2);
+    engine->fill_rect(-1, 1, 10, 10, 'x');
+    EXPECT_EQ(engine->get_cell(0, 1), ConsoleCell('x'));
+    EXPECT_EQ(engine->get_cell(2, 1), ConsoleCell('x'));
+    EXPECT_EQ(engine->get_cell(0, 0), ConsoleCell());
+    SavedRegion region = engine->save_region(2, 1, 2, 2);
+    EXPECT_EQ(region.cells.at(0, 0), ConsoleCell('x'));
+    engine->restore_region(region);
+}
+
+class InputParserTest : public ::testing::Test {
+  protected:
+    InputParser parser;
+    InputParser::Clock::time_point now{};
+
+    std::vector<KeyEvent> feed(std::string_view bytes) {
+        std::vector<KeyEvent> events;
+        for (char c : bytes) {
+            KeyEvent event;
+            if (parser.feed(c, now, event)) events.push_back(event);
+        }
+        return events;
+    }
+};
+
+TEST_F(InputParserTest, PlainKeys) {
+    auto events = feed("a\r\x7f");
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].key, Key::Char);
+    EXPECT_EQ(events[0].ch, 'a');
+    EXPECT_EQ(events[1].key, Key::Enter);
+    EXPECT_EQ(events[2].key, Key::Backspace);
+}
+
+TEST_F(InputParserTest, ArrowSplitAcrossReads) {
+    EXPECT_TRUE(feed("\033").empty());
+    EXPECT_TRUE(feed("[").empty());
+    auto events = feed("Aw");
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].key, Key::Up);
+    EXPECT_EQ(events[1].ch, 'w');
+}
+
+TEST_F(InputParserTest, ModifiersAndFunctionKeys) {
+    auto events = feed("\033[1;5C\033[15~\033OP\033x");
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0].key, Key::Right);
+    EXPECT_EQ(events[0].mods, KeyMods::Ctrl);
+    EXPECT_EQ(events[1].key, Key::F5);
+    EXPECT_EQ(events[2].key, Key::F1);
+    EXPECT_EQ(events[3].ch, 'x');
+    EXPECT_EQ(events[3].mods, KeyMods::Alt);
+}
+
+TEST_F(InputParserTest, LoneEscapeAfterTimeout) {
+    EXPECT_TRUE(feed("\033").empty());
+    KeyEvent event;
+    EXPECT_FALSE(parser.flush(now, event));
+    EXPECT_TRUE(parser.flush(now + InputParser::escape_timeout, event));
+    EXPECT_EQ(event.key, Key::Escape);
+    EXPECT_EQ(feed("w").at(0).ch, 'w');
+}
+
+TEST_F(InputParserTest, UnknownSequenceIsDropped) {
+    auto events = feed("\033[99~q");
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].ch, 'q');
+}
+
+TEST_F(InputParserTest, TerminalReplyIsSwallowed) {
+    // Ответ на DA и отчет о фокусе: ни один байт не становится клавишей,
+    // даже если окончание похоже на стрелку
+    auto events = feed("\033[?1;2c\033[>0;95;0c\033[?25A\033[ q");
+    EXPECT_TRUE(events.empty());
+    events = feed("\033[Ad");
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].key, Key::Up);
+    EXPECT_EQ(events[1].ch, 'd');
+}
+
+TEST_F(InputParserTest, AltBracketAfterTimeout) {
+    KeyEvent event;
+    for (char c : {'[', 'O'}) {
+        feed(std::string("\033") + c);
+        EXPECT_FALSE(parser.flush(now, event));
+        ASSERT_TRUE(parser.flush(now + InputParser::escape_timeout, event));
+        EXPECT_EQ(event.key, Key::Char);
+        EXPECT_EQ(event.ch, c);
+        EXPECT_EQ(event.mods, KeyMods::Alt);
+    }
+    // Оборванная последовательность с параметрами просто пропадает
+    feed("\033[1;");
+    EXPECT_FALSE(parser.flush(now + InputParser::escape_timeout, event));
+    EXPECT_EQ(feed("w").at(0).ch, 'w');
+}
+
+TEST_F(ConsoleEngineTest, PollEventParsesArrows) {
+    in.str("\033[Bd");
+    KeyEvent event;
+    ASSERT_TRUE(engine->poll_event(event));
+    EXPECT_EQ(event.key, Key::Down);
+    EXPECT_FALSE(engine->key_pressed('B'));
+    ASSERT_TRUE(engine->poll_event(event));
+    EXPECT_EQ(event.ch, 'd');
+    EXPECT_FALSE(engine->poll_event(event));
+}
+
+TEST(FrameStatsTest, PercentilesOverRing) {
+    FrameStats stats;
+    for (int i = 1; i <= 100; ++i) stats.end_frame({}, {}, i, 0);
+    FrameStats::Summary bytes = stats.summary(FrameMetric::Bytes);
+    EXPECT_EQ(bytes.p50, 50u);
+    EXPECT_EQ(bytes.p90, 90u);
+    EXPECT_EQ(bytes.p99, 99u);
+    EXPECT_EQ(bytes.max, 100u);
+
+    for (std::size_t i = 0; i < FrameStats::capacity; ++i)
+        stats.end_frame({}, {}, 1, 0);
+    EXPECT_EQ(stats.size(), FrameStats::capacity);
+    EXPECT_EQ(stats.summary(FrameMetric::Bytes).max, 1u);
+}
+
+TEST(FrameStatsTest, WritesCsv) {
+    using namespace std::chrono_literals;
+    FrameStats stats;
+    stats.add_update_time(3ms);
+    stats.add_keys(2);
+    stats.end_frame(5us, 7us, 40, 4);
+    std::ostringstream csv;
+    stats.write_csv(csv);
+    EXPECT_EQ(csv.str(),
+              "frame,update_us,render_us,flush_us,bytes,cells,keys\n"
+              "0,3000,5,7,40,4,2\n");
+}
+
+TEST_F(ConsoleEngineTest, PresentRecordsStats) {
+    in.str("ab");
+    engine->drain_keys();
+    engine->resize_buffer(3, 1);
+    engine->present();
+    const FrameStats::Sample& last = engine->stats().last();
+    EXPECT_EQ(last[size_t(FrameMetric::CellsChanged)], 3u);
+    EXPECT_EQ(last[size_t(FrameMetric::Bytes)], out.str().size());
+    EXPECT_EQ(last[size_t(FrameMetric::Keys)], 2u);
+}
+
+TEST_F(ConsoleEngineTest, RenderThreadReportsStats) {
+    using namespace std::chrono_literals;
+    engine->resize_buffer(3, 1);
+    engine->start_render_thread();
+    engine->present();
+    // Замеры кадра приходят с одним из следующих present()
+    uint64_t bytes = 0;
+    uint64_t cells = 0;
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (cells == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+        engine->present();
+        const FrameStats::Sample& last = engine->stats().last();
+        bytes += last[size_t(FrameMetric::Bytes)];
+        cells += last[size_t(FrameMetric::CellsChanged)];
+    }
+    engine->stop_render_thread();
+    EXPECT_EQ(cells, 3u);
+    EXPECT_EQ(bytes, out.str().size());
+}
+
+TEST(EventLoopTest, TimersFireInOrder) {
+    using namespace std::chrono_literals;
+    EventLoop loop;
+    std::string fired;
+    loop.add_timer(2ms, [&] { fired += 'b'; });
+    loop.add_timer(1ms, [&] { fired += 'a'; });
+    auto cancelled = loop.add_timer(1ms, [&] { fired += 'x'; });
+    loop.cancel_timer(cancelled);
+    // Оба срока уже прошли - срабатывают за один проход
+    std::this_thread::sleep_for(5ms);
+    EXPECT_TRUE(loop.run_once());
+    EXPECT_EQ(fired, "ab");
+    EXPECT_FALSE(loop.run_once(EventLoop::Clock::now() + 1ms));
+}
+
+TEST(EventLoopTest, WakeFromAnotherThread) {
+    EventLoop loop;
+    std::thread waker([&] { loop.wake(); });
+    EXPECT_TRUE(loop.run_once());
+    waker.join();
+}
+
+#ifndef _WIN32
+TEST(TerminalWindowTest, ColorDepthDefaultsTo256) {
+    auto depth_for = [](const char* term) {
+        if (term)
+            setenv("TERM", term, 1);
+        else
+            unsetenv("TERM");
+        return TerminalWindow::color_depth();
+    };
+    const char* saved_term = std::getenv("TERM");
+    std::string saved = saved_term ? saved_term : "";
+    unsetenv("CONSOLE_ENGINE_COLORS");
+
+    EXPECT_EQ(depth_for("xterm"), ColorDepth::Ansi256);
+    EXPECT_EQ(depth_for("screen"), ColorDepth::Ansi256);
+    EXPECT_EQ(depth_for(nullptr), ColorDepth::Ansi256);
+    EXPECT_EQ(depth_for("linux"), ColorDepth::Ansi16);
+    EXPECT_EQ(depth_for("dumb"), ColorDepth::Mono);
+    EXPECT_EQ(depth_for("vt100"), ColorDepth::Mono);
+    setenv("CONSOLE_ENGINE_COLORS", "16", 1);
+    EXPECT_EQ(depth_for("xterm-256color"), ColorDepth::Ansi16);
+    unsetenv("CONSOLE_ENGINE_COLORS");
+
+    if (saved_term)
+        setenv("TERM", saved.c_str(), 1);
+    else
+        unsetenv("TERM");
+}
+
+// stdin - канал, который закрывается после "d". Ожидание после конца
+// ввода не должно зависнуть в poll()
+TEST(ConsoleEngineStdinTest, WaitReturnsAfterEndOfInput) {
+    int pipe_fds[2];
+    ASSERT_EQ(pipe(pipe_fds), 0);
+    ASSERT_EQ(write(pipe_fds[1], "d", 1), 1);
+    close(pipe_fds[1]);
+    std::cout.flush();
+    int saved_in = dup(STDIN_FILENO), saved_out = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(pipe_fds[0], STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    {
+        ConsoleEngine engine;
+        KeyEvent event;
+        ASSERT_TRUE(engine.wait_event(event));
+        EXPECT_EQ(event.ch, 'd');
+        EXPECT_FALSE(engine.wait_event(event));
+        EXPECT_TRUE(engine.input_closed());
+        EXPECT_FALSE(engine.wait_input(EventLoop::Clock::time_point::max()));
+    }
+    std::cout.flush();
+    dup2(saved_in, STDIN_FILENO);
+    dup2(saved_out, STDOUT_FILENO);
+    for (int fd : {saved_in, saved_out, null_fd, pipe_fds[0]}) close(fd);
+}
+#endif
+
+TEST_F(ConsoleEngineTest, WaitEventReturnsQueuedKey) {
+    using namespace std::chrono_literals;
+    in.str("\033[B");
+    KeyEvent event;
+    ASSERT_TRUE(engine->wait_event(event, EventLoop::Clock::now() + 1s));
+    EXPECT_EQ(event.key, Key::Down);
+    EXPECT_FALSE(engine->wait_event(event, EventLoop::Clock::now() + 1ms));
+}
+
+TEST_F(ConsoleEngineTest, SynchronizedOutputWrapsChangedFrames) {
+    engine->set_synchronized_output(true);
+    engine->resize_buffer(2, 1);
+    engine->set_cell(0, 0, 'a');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[?2026h\033[H\033[0ma \033[?2026l");
+    out.str("");
+    engine->present();
+    EXPECT_EQ(out.str(), "");
+}
+
+TEST(FrameBufferTest, ScrollShiftsRowsInRegion) {
+    FrameBuffer buffer(1, 4);
+    for (int y = 0; y < 4; ++y) buffer.at(0, y) = ConsoleCell(char('a' + y));
+    buffer.scroll(1, 4, 1, '.');
+    EXPECT_EQ(buffer.at(0, 0).glyph, 'a');
+    EXPECT_EQ(buffer.at(0, 1).glyph, 'c');
+    EXPECT_EQ(buffer.at(0, 2).glyph, 'd');
+    EXPECT_EQ(buffer.at(0, 3).glyph, '.');
+    buffer.scroll(0, 4, -2, '.');
+    EXPECT_EQ(buffer.at(0, 0).glyph, '.');
+    EXPECT_EQ(buffer.at(0, 1).glyph, '.');
+    EXPECT_EQ(buffer.at(0, 2).glyph, 'a');
+    EXPECT_EQ(buffer.at(0, 3).glyph, 'c');
+}
+
+TEST_F(ConsoleEngineTest, ScrollRegionSendsOnlyExposedRow) {
+    constexpr int width = 20;
+    engine->resize_buffer(width, 4);
+    for (int y = 0; y < 4; ++y)
+        engine->draw_text(0, y, std::string(width, char('a' + y)));
+    engine->present();
+    out.str("");
+
+    engine->scroll_region(0, 4, -1);
+    EXPECT_EQ(engine->get_cell(0, 1).glyph, 'a');
+    engine->draw_text(0, 0, std::string(width, 'x'));
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[1;4r\033[T\033[r" + std::string(width, 'x'));
+}
+
+TEST_F(ConsoleEngineTest, ScrollRegionSkippedWhenRedrawIsCheaper) {
+    engine->resize_buffer(20, 4);
+    engine->fill_rect(0, 0, 20, 4, '.');
+    engine->present();
+    out.str("");
+
+    engine->scroll_region(0, 4, -1);
+    engine->fill_rect(0, 0, 20, 4, '.');
+    engine->set_cell(5, 2, 'C');
+    engine->present();
+    EXPECT_EQ(out.str(), "\033[3;6HC");
+}
+
+TEST(FrameBufferTest, BlitClipsAndSkipsTransparent) {
+    const std::array<std::array<char, 3>, 2> sprite = {
+        {{{'a', '.', 'b'}}, {{'c', 'd', 'e'}}}};
+    FrameBuffer buffer(3, 2, '#');
+    buffer.blit(-1, 1, sprite, ConsoleCell(' ', Colors256::Red), '.');
+    EXPECT_EQ(buffer.at(0, 0).glyph, '#');
+    EXPECT_EQ(buffer.at(0, 1).glyph, '#');
+    EXPECT_EQ(buffer.at(1, 1), ConsoleCell('b', Colors256::Red));
+    EXPECT_EQ(buffer.at(2, 1).glyph, '#');
+
+    buffer.blit(1, -1, sprite);
+    EXPECT_EQ(buffer.at(1, 0).glyph, 'c');
+    EXPECT_EQ(buffer.at(2, 0).glyph, 'd');
+}
+
+TEST(AnsiEncoderTest, ColorDepthMapsColors) {
+    FrameBuffer frame(2, 1), screen;
+    frame.at(0, 0) = ConsoleCell('a', Colors256::Red);
+    frame.at(1, 0) = ConsoleCell('b', Colors256::White, Colors256::Gray50);
+    AnsiEncoder encoder;
+    encoder.set_color_depth(ColorDepth::Ansi16);
+    std::string out;
+    encoder.encode_frame(out, frame, screen);
+    EXPECT_EQ(out, "\033[H\033[0;91ma\033[97;100mb\033[0m");
+
+    AnsiEncoder mono;
+    mono.set_color_depth(ColorDepth::Mono);
+    FrameBuffer mono_screen;
+    out.clear();
+    mono.encode_frame(out, frame, mono_screen);
+    EXPECT_EQ(out, "\033[H\033[0ma\033[7mb\033[0m");
+}
+
+TEST(AnsiEncoderTest, OverBudgetFrameUsesFewerColors) {
+    FrameBuffer frame(20, 1), screen;
+    for (int x = 0; x < 20; ++x) frame.at(x, 0) = ConsoleCell('#', 16 + x);
+    AnsiEncoder encoder;
+    std::string out;
+    encoder.encode_frame(out, frame, screen, 40);
+    EXPECT_EQ(encoder.color_depth(), ColorDepth::Mono);
+    EXPECT_EQ(out, "\033[H\033[0m" + std::string(20, '#'));
+
+    // Канал снова быстрый - всё перерисовывается в полном цвете
+    out.clear();
+    encoder.encode_frame(out, frame, screen);
+    EXPECT_EQ(encoder.color_depth(), ColorDepth::Ansi256);
+    EXPECT_NE(out.find("38;5;35"), std::string::npos);
+}
+
+TEST(AnsiEncoderTest, CalmUpgradeRepaintsReducedCells) {
+    FrameBuffer frame(20, 2), screen;
+    for (int x = 0; x < 20; ++x) frame.at(x, 0) = ConsoleCell('#', 16 + x);
+    // Нижняя строка без цвета выглядит одинаково при любой глубине
+    for (int x = 0; x < 20; ++x) frame.at(x, 1) = ConsoleCell('.');
+    AnsiEncoder encoder;
+    std::string out;
+    encoder.encode_frame(out, frame, screen, 60);
+    ASSERT_EQ(encoder.color_depth(), ColorDepth::Mono);
+
+    const std::size_t budget = 100000;
+    std::string upgrade;
+    for (int i = 0; i < 100 && encoder.color_depth() != ColorDepth::Ansi256;
+         ++i) {
+        out.clear();
+        encoder.encode_frame(out, frame, screen, budget);
+        if (!out.empty()) upgrade = out;
+    }
+    ASSERT_EQ(encoder.color_depth(), ColorDepth::Ansi256);
+    // Цветная строка перерисована в 256 цветах, бесцветная не тронута
+    EXPECT_NE(upgrade.find("38;5;35m"), std::string::npos);
+    EXPECT_EQ(upgrade.find('.'), std::string::npos);
+    out.clear();
+    encoder.encode_frame(out, frame, screen, budget);
+    EXPECT_EQ(out, "");
+}
+
+TEST(AnsiEncoderTest, FailedUpgradeKeepsScreen) {
+    FrameBuffer frame(20, 1);
+    for (int x = 0; x < 20; ++x) frame.at(x, 0) = ConsoleCell('#', 16 + x);
+    auto full_size = [&](ColorDepth depth) {
+        AnsiEncoder encoder;
+        encoder.set_color_depth(depth);
+        FrameBuffer screen;
+        std::string out;
+        encoder.encode_frame(out, frame, screen);
+        return out.size();
+    };
+    std::size_t size16 = full_size(ColorDepth::Ansi16);
+    std::size_t size256 = full_size(ColorDepth::Ansi256);
+    ASSERT_LT(size16, size256);
+    // 16 цветов влезают, 256 - нет
+    std::size_t budget = (size16 + size256) / 2;
+
+    AnsiEncoder encoder;
+    FrameBuffer screen;
+    std::string out;
+    encoder.encode_frame(out, frame, screen, budget);
+    ASSERT_EQ(encoder.color_depth(), ColorDepth::Ansi16);
+    // Кадр не меняется: попытка вернуть 256 цветов не влезает, откат
+    // оставляет screen прежним и выводить нечего
+    for (int i = 0; i < 100; ++i) {
+        out.clear();
+        encoder.encode_frame(out, frame, screen, budget);
+        EXPECT_EQ(out, "") << i;
+        EXPECT_EQ(encoder.color_depth(), ColorDepth::Ansi16);
+    }
+}
+
+TEST(AnsiEncoderTest, OverBudgetRetryStartsFromSameState) {
+    auto row = [](int n, int x) {
+        return ConsoleCell('a' + n % 26, 16 + n + x);
+    };
+    FrameBuffer frame(10, 8), screen;
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 10; ++x) frame.at(x, y) = row(y, x);
+    AnsiEncoder encoder;
+    std::string out;
+    encoder.encode_frame(out, frame, screen);
+
+    // Копия переходит в монохром сразу, без неудачных попыток
+    AnsiEncoder expected_encoder = encoder;
+    FrameBuffer expected_screen = screen;
+    expected_encoder.set_color_depth(ColorDepth::Mono);
+
+    // Дорога уехала на строку вниз, сверху новая строка
+    frame.scroll(0, 8, -1, ConsoleCell());
+    for (int x = 0; x < 10; ++x) frame.at(x, 0) = row(20, x);
+    encoder.request_scroll(0, 8, -1);
+    expected_encoder.request_scroll(0, 8, -1);
+    out.clear();
+    encoder.encode_frame(out, frame, screen, 1);
+    std::string expected;
+    expected_encoder.encode_frame(expected, frame, expected_screen);
+
+    EXPECT_EQ(encoder.color_depth(), ColorDepth::Mono);
+    EXPECT_NE(out.find("\033[T"), std::string::npos);
+    EXPECT_EQ(out, expected);
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 10; ++x)
+            EXPECT_EQ(screen.at(x, y), expected_screen.at(x, y));
+}
+
+TEST(OutputBudgetTest, SlowWritesLimitFrame) {
+    using namespace std::chrono_literals;
+    OutputBudget budget;
+    auto now = OutputBudget::Clock::now();
+    for (int i = 0; i < 20; ++i) {
+        budget.frame_started(now + i * 100ms);
+        budget.wrote(1000, 10us);
+    }
+    EXPECT_EQ(budget.frame_budget(), OutputBudget::unlimited);
+    // 1000 байт за 100 мс - 10 КБ/с, за кадр в 100 мс успевает 1000
+    for (int i = 20; i < 60; ++i) {
+        budget.frame_started(now + i * 100ms);
+        budget.wrote(1000, 100ms);
+    }
+    EXPECT_NEAR(double(budget.frame_budget()), 1000.0, 50.0);
+}
+
+TEST(StyleCacheTest, InternsVisibleStyle) {
+    StyleCache cache;
+    ConsoleCell red('a', Colors256::Red);
+    ConsoleCell other_glyph('b', Colors256::Red);
+    ConsoleCell plain('c');
+    plain.fg = Colors256::Blue;  // без TextColor цвет не виден
+    int id = cache.intern(red, ColorDepth::Ansi256);
+    EXPECT_NE(id, StyleCache::unknown);
+    EXPECT_EQ(cache.intern(other_glyph, ColorDepth::Ansi256), id);
+    EXPECT_EQ(cache.intern(plain, ColorDepth::Ansi256),
+              cache.intern(ConsoleCell(), ColorDepth::Ansi256));
+    EXPECT_NE(cache.intern(red, ColorDepth::Ansi16), id);
+
+    EXPECT_EQ(cache.find(StyleCache::unknown, id), "");
+    cache.store(StyleCache::unknown, id, "\033[0;38;5;196m");
+    EXPECT_EQ(cache.find(StyleCache::unknown, id), "\033[0;38;5;196m");
+}
+
+TEST_F(ConsoleEngineTest, CachedStyleTransitionsMatchEncoded) {
+    engine->resize_buffer(4, 1);
+    engine->set_cell(0, 0, ConsoleCell('~', Colors256::Blue));
+    engine->set_cell(1, 0, ConsoleCell('.', Colors256::Green));
+    engine->set_cell(2, 0, ConsoleCell('~', Colors256::Blue));
+    engine->set_cell(3, 0, ConsoleCell('.', Colors256::Green));
+    engine->present();
+    EXPECT_EQ(out.str(),
+              "\033[H\033[0;38;5;21m~\033[38;5;46m.\033[38;5;21m~"
+              "\033[38;5;46m.\033[0m");
+}
@@ -0,0 +1,46 @@
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "ConsoleEngine.h"
+
+// Воспроизведение записи, сделанной с CONSOLE_ENGINE_RECORD=file:
+// ConsoleReplay file [--fast]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <recording> [--fast]\n";
+        return 1;
+    }
+    bool fast = argc > 2 && std::string(argv[2]) == "--fast";
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << argv[1] << "\n";
+        return 1;
+    }
+
+    try {
+        FramePlayer player(file);
+        ConsoleEngine engine;
+        // Иначе с CONSOLE_ENGINE_RECORD воспроизведение запишется поверх
+        engine.stop_recording();
+        engine.clear();
+        engine.hide_cursor();
+        while (player.next()) {
+            if (!fast) std::this_thread::sleep_for(player.delay());
+            const FrameBuffer& frame = player.frame();
+            if (engine.buffer_width() != frame.width() ||
+                engine.buffer_height() != frame.height())
+                engine.resize_buffer(frame.width(), frame.height());
+            for (int y = 0; y < frame.height(); ++y)
+                for (int x = 0; x < frame.width(); ++x)
+                    engine.set_cell(x, y, frame.at(x, y));
+            engine.present();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
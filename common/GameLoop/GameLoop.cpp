@@ -0,0 +1,90 @@
+#include "GameLoop.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+GameLoop::GameLoop(Clock::duration step, Clock::duration frame_interval)
+    : step_(step), frame_interval_(frame_interval) {}
+
+void GameLoop::set_max_catch_up_steps(int max_steps) {
+    max_steps_ = std::max(1, max_steps);
+}
+
+void GameLoop::set_input_poll_interval(Clock::duration interval) {
+    input_poll_interval_ = interval;
+}
+
+void GameLoop::set_wait(Wait wait) { wait_ = std::move(wait); }
+
+void GameLoop::set_clock(Now now) { now_ = std::move(now); }
+
+void GameLoop::stop() { running_ = false; }
+
+void GameLoop::run(const Input& input, const Update& update,
+                   const Render& render) {
+    running_ = true;
+    auto next_step = now_() + step_;
+    auto next_frame = now_();
+    bool dirty = true;
+    // Самый ранний ввод, который еще не попал на экран
+    bool has_pending_input = false;
+    Clock::time_point pending_input{};
+
+    while (running_) {
+        if (input()) {
+            dirty = true;
+            if (!has_pending_input) {
+                pending_input = now_();
+                has_pending_input = true;
+            }
+        }
+
+        auto now = now_();
+        int steps = 0;
+        while (running_ && now >= next_step && steps < max_steps_) {
+            auto update_start = now_();
+            update();
+            update_time_ += now_() - update_start;
+            next_step += step_;
+            ++steps;
+            dirty = true;
+        }
+        if (now >= next_step) {
+            skipped_steps_ += (now - next_step) / step_ + 1;
+            next_step = now + step_;
+        }
+        if (!running_) break;
+
+        if (dirty && now >= next_frame) {
+            render();
+            update_time_ = Clock::duration::zero();
+            dirty = false;
+            next_frame = now + frame_interval_;
+            if (has_pending_input) {
+                record_latency(now_() - pending_input);
+                has_pending_input = false;
+            }
+        }
+
+        auto wake = next_step;
+        if (dirty) wake = std::min(wake, next_frame);
+        if (wait_)
+            wait_(wake);
+        else
+            std::this_thread::sleep_until(
+                std::min(wake, now + input_poll_interval_));
+    }
+}
+
+void GameLoop::record_latency(Clock::duration latency) {
+    last_latency_ = latency;
+    max_latency_ = std::max(max_latency_, latency);
+    total_latency_ += latency;
+    ++latency_samples_;
+}
+
+GameLoop::Clock::duration GameLoop::average_latency() const {
+    if (latency_samples_ == 0) return Clock::duration::zero();
+    return total_latency_ / latency_samples_;
+}
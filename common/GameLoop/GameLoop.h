@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Игровой цикл с фиксированным шагом симуляции. Ввод опрашивается на
+// каждой итерации, update() вызывается ровно раз в step, а кадр рисуется
+// не чаще frame_interval и только если что-то изменилось. Между делами цикл
+// спит до ближайшего дедлайна, поэтому темп не зависит от времени работы
+class GameLoop {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // Вернуть true, если пришел ввод - от этого момента считается задержка
+    using Input = std::function<bool()>;
+    using Update = std::function<void()>;
+    using Render = std::function<void()>;
+    // Ждет до дедлайна; может вернуться раньше, если пришел ввод
+    using Wait = std::function<void(Clock::time_point)>;
+    using Now = std::function<Clock::time_point()>;
+
+    GameLoop(Clock::duration step, Clock::duration frame_interval);
+
+    // Если кадр задержался, шаги догоняются, но не больше max_steps за
+    // итерацию. Остальные пропускаются, чтобы игра не ушла в спираль
+    void set_max_catch_up_steps(int max_steps);
+    // Как часто проверять ввод, пока ждем следующего шага
+    void set_input_poll_interval(Clock::duration interval);
+    // Без него цикл спит и просыпается проверить ввод раз в
+    // input_poll_interval. Если wait сам просыпается от ввода (например,
+    // ConsoleEngine::wait_input), опрашивать не нужно
+    void set_wait(Wait wait);
+    // Источник времени; по умолчанию Clock::now. Тесты подставляют свои
+    // часы и двигают их в wait
+    void set_clock(Now now);
+
+    // Крутится, пока не вызван stop()
+    void run(const Input& input, const Update& update, const Render& render);
+    void stop();
+
+    // Задержка от ввода до отрисованного кадра
+    Clock::duration last_latency() const { return last_latency_; }
+    Clock::duration max_latency() const { return max_latency_; }
+    Clock::duration average_latency() const;
+    uint64_t skipped_steps() const { return skipped_steps_; }
+    // Сколько заняли update() с прошлого кадра - для замеров внутри render
+    Clock::duration update_time() const { return update_time_; }
+
+  private:
+    Clock::duration step_;
+    Clock::duration frame_interval_;
+    Clock::duration input_poll_interval_ = std::chrono::milliseconds(10);
+    int max_steps_ = 5;
+    Wait wait_;
+    Now now_ = [] { return Clock::now(); };
+    bool running_ = false;
+
+    Clock::duration last_latency_{};
+    Clock::duration max_latency_{};
+    Clock::duration total_latency_{};
+    uint64_t latency_samples_ = 0;
+    uint64_t skipped_steps_ = 0;
+    Clock::duration update_time_{};
+
+    void record_latency(Clock::duration latency);
+};
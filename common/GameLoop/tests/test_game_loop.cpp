@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "GameLoop.h"
+
+using namespace std::chrono_literals;
+
+// Часы, которые двигает только сам тест: wait перескакивает к дедлайну,
+// не дальше шага опроса ввода
+class GameLoopTest : public ::testing::Test {
+  protected:
+    GameLoop::Clock::time_point now{};
+    GameLoop::Clock::duration poll = 1h;
+
+    void attach(GameLoop& loop) {
+        loop.set_clock([this] { return now; });
+        loop.set_wait([this](GameLoop::Clock::time_point deadline) {
+            now = std::max(now, std::min(deadline, now + poll));
+        });
+    }
+    GameLoop::Clock::duration elapsed() const {
+        return now - GameLoop::Clock::time_point{};
+    }
+};
+
+TEST_F(GameLoopTest, UpdatesAtFixedStep) {
+    GameLoop loop(10ms, 0ms);
+    attach(loop);
+    std::vector<GameLoop::Clock::duration> times;
+    loop.run([] { return false; },
+             [&] {
+                 times.push_back(elapsed());
+                 if (times.size() == 5) loop.stop();
+             },
+             [] {});
+    std::vector<GameLoop::Clock::duration> expected = {10ms, 20ms, 30ms, 40ms,
+                                                       50ms};
+    EXPECT_EQ(times, expected);
+    EXPECT_EQ(loop.skipped_steps(), 0u);
+}
+
+TEST_F(GameLoopTest, CatchUpIsClamped) {
+    GameLoop loop(10ms, 0ms);
+    loop.set_max_catch_up_steps(3);
+    attach(loop);
+    int updates = 0;
+    loop.run([] { return false; },
+             [&] {
+                 // Первый шаг завис на 100 мс: догоняются только 3 шага
+                 if (++updates == 1) now += 100ms;
+                 if (updates == 4) loop.stop();
+             },
+             [] {});
+    EXPECT_EQ(updates, 4);
+    // Шаги 50..110 мс пропущены, следующий - через step от текущего времени
+    EXPECT_EQ(loop.skipped_steps(), 7u);
+}
+
+TEST_F(GameLoopTest, RenderRateIsCapped) {
+    GameLoop loop(1ms, 10ms);
+    attach(loop);
+    int updates = 0;
+    int renders = 0;
+    loop.run([] { return false; },
+             [&] {
+                 if (++updates == 100) loop.stop();
+             },
+             [&] { ++renders; });
+    EXPECT_EQ(updates, 100);
+    // Кадры на 0, 10, ..., 90 мс
+    EXPECT_EQ(renders, 10);
+}
+
+TEST_F(GameLoopTest, MeasuresInputLatency) {
+    GameLoop loop(100ms, 16ms);
+    poll = 5ms;
+    attach(loop);
+    bool pressed = false;
+    int renders = 0;
+    loop.run(
+        [&] {
+            if (pressed || now < GameLoop::Clock::time_point{} + 5ms)
+                return false;
+            pressed = true;
+            return true;
+        },
+        [] {},
+        [&] {
+            if (++renders == 2) loop.stop();
+        });
+    // Ввод на 5 мс, ближайший разрешенный кадр - на 16 мс
+    EXPECT_EQ(loop.last_latency(), 11ms);
+    EXPECT_EQ(loop.max_latency(), 11ms);
+    EXPECT_EQ(loop.average_latency(), 11ms);
+}